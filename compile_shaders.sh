@@ -2,5 +2,11 @@ for f in shaders/*; do
     if [[ $f != *".spv" ]] && [[ $f != *".glsl" ]]; then # Skip compiled files
         echo "Compiling $f"
         glslc "$f" -o "$f.spv"
+
+        # Vertex shaders reading vertex_input.glsl also get a variant for VertexFormat::Packed
+        if grep -q "vertex_input.glsl" "$f"; then
+            echo "Compiling $f (packed vertices)"
+            glslc -DPACKED_VERTEX "$f" -o "${f%.vert}_packed.vert.spv"
+        fi
     fi
 done
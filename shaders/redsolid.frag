@@ -1,22 +1,18 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(binding = 0) uniform LocalTransform {
-    mat4 model;
+layout(set = 0, binding = 0) uniform Globals {
     mat4 view;
     mat4 proj;
     mat4 lightSpace;
-} t;
-
-layout(binding = 1) uniform Globals {
     vec3 viewPos;
     vec3 ambientColor;
 } globals;
 
-layout(binding = 2) uniform sampler2D albedoTex;
-layout(binding = 3) uniform sampler2D maskTex;
-layout(binding = 4) uniform sampler2D normalMapTex;
-layout(binding = 5) uniform sampler2D shadowMapTex;
+layout(set = 1, binding = 1) uniform sampler2D albedoTex;
+layout(set = 1, binding = 2) uniform sampler2D maskTex;
+layout(set = 1, binding = 3) uniform sampler2D normalMapTex;
+layout(set = 1, binding = 4) uniform sampler2D shadowMapTex;
 
 layout(location = 0) in vec3 fragPos;
 layout(location = 1) in vec4 fragColor;
@@ -1,15 +1,19 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(binding = 0) uniform LocalTransform {
+layout(push_constant) uniform LocalTransform {
     mat4 model;
+} t;
+
+// Leading members of Globals, see shader.frag
+layout(set = 0, binding = 0) uniform Globals {
     mat4 view;
     mat4 proj;
     mat4 lightSpace;
-} t;
+} globals;
 
 layout(location = 0) in vec3 inPosition;
 
 void main() {
-    gl_Position = t.lightSpace * t.model * vec4(inPosition, 1.0);
+    gl_Position = globals.lightSpace * t.model * vec4(inPosition, 1.0);
 }
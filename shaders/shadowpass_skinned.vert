@@ -3,23 +3,30 @@
 
 const int MAX_BONES = 64;
 
-layout(binding = 0) uniform LocalTransform {
+layout(push_constant) uniform LocalTransform {
     mat4 model;
+} t;
+
+// Leading members of Globals, see shader.frag
+layout(set = 0, binding = 0) uniform Globals {
     mat4 view;
     mat4 proj;
     mat4 lightSpace;
+} globals;
+
+layout(set = 1, binding = 0) readonly buffer BonePalette {
     mat4 boneTransforms[MAX_BONES];
-} t;
+} bones;
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 5) in uvec4 inBoneIds;
 layout(location = 6) in vec4 inBoneWeights;
 
 void main() {
-    mat4 boneTransform = t.boneTransforms[inBoneIds[0]] * inBoneWeights[0];
-    boneTransform += t.boneTransforms[inBoneIds[1]] * inBoneWeights[1];
-    boneTransform += t.boneTransforms[inBoneIds[2]] * inBoneWeights[2];
-    boneTransform += t.boneTransforms[inBoneIds[3]] * inBoneWeights[3];
+    mat4 boneTransform = bones.boneTransforms[inBoneIds[0]] * inBoneWeights[0];
+    boneTransform += bones.boneTransforms[inBoneIds[1]] * inBoneWeights[1];
+    boneTransform += bones.boneTransforms[inBoneIds[2]] * inBoneWeights[2];
+    boneTransform += bones.boneTransforms[inBoneIds[3]] * inBoneWeights[3];
     
-    gl_Position = t.lightSpace * t.model * boneTransform * vec4(inPosition, 1.0);
+    gl_Position = globals.lightSpace * t.model * boneTransform * vec4(inPosition, 1.0);
 }
@@ -3,19 +3,26 @@
 
 const int MAX_BONES = 64;
 
-layout(binding = 0) uniform LocalTransform {
+layout(push_constant) uniform LocalTransform {
     mat4 model;
+} t;
+
+// Leading members of Globals, see shader.frag
+layout(set = 0, binding = 0) uniform Globals {
     mat4 view;
     mat4 proj;
     mat4 lightSpace;
+} globals;
+
+layout(set = 1, binding = 0) readonly buffer BonePalette {
     mat4 boneTransforms[MAX_BONES];
-} t;
+} bones;
+
+#include "vertex_input.glsl"
 
 layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec4 inColor;
 layout(location = 3) in vec2 inTexCoord;
-layout(location = 4) in vec4 inTangent;
 layout(location = 5) in uvec4 inBoneIds;
 layout(location = 6) in vec4 inBoneWeights;
 
@@ -27,10 +34,10 @@ layout(location = 4) out mat3 fragTbn;
 layout(location = 7) out vec4 fragShadowCoord;
 
 void main() {
-    mat4 boneTransform = t.boneTransforms[inBoneIds[0]] * inBoneWeights[0];
-    boneTransform += t.boneTransforms[inBoneIds[1]] * inBoneWeights[1];
-    boneTransform += t.boneTransforms[inBoneIds[2]] * inBoneWeights[2];
-    boneTransform += t.boneTransforms[inBoneIds[3]] * inBoneWeights[3];
+    mat4 boneTransform = bones.boneTransforms[inBoneIds[0]] * inBoneWeights[0];
+    boneTransform += bones.boneTransforms[inBoneIds[1]] * inBoneWeights[1];
+    boneTransform += bones.boneTransforms[inBoneIds[2]] * inBoneWeights[2];
+    boneTransform += bones.boneTransforms[inBoneIds[3]] * inBoneWeights[3];
     
     fragPos = vec3(t.model * boneTransform * vec4(inPosition, 1.0));
     fragColor = inColor;
@@ -46,7 +53,7 @@ void main() {
     vec3 B = cross(T, N) * inTangent.w;
     fragTbn = mat3(T, B, N);
     
-    fragShadowCoord = t.lightSpace * vec4(fragPos, 1.0);
+    fragShadowCoord = globals.lightSpace * vec4(fragPos, 1.0);
     
-    gl_Position = t.proj * t.view * vec4(fragPos, 1.0);
+    gl_Position = globals.proj * globals.view * vec4(fragPos, 1.0);
 }
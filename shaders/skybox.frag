@@ -1,13 +1,7 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(binding = 0) uniform LocalTransform {
-    mat4 model;
-    mat4 view;
-    mat4 proj;
-} t;
-
-layout(binding = 2) uniform samplerCube albedoTex;
+layout(set = 1, binding = 1) uniform samplerCube albedoTex;
 
 layout(location = 0) in vec3 fragTexCoord;
 
@@ -1,11 +1,16 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(binding = 0) uniform LocalTransform {
+layout(push_constant) uniform LocalTransform {
     mat4 model;
+} t;
+
+// Leading members of Globals, see shader.frag
+layout(set = 0, binding = 0) uniform Globals {
     mat4 view;
     mat4 proj;
-} t;
+    mat4 lightSpace;
+} globals;
 
 layout(location = 0) in vec3 inPosition;
 
@@ -15,6 +20,6 @@ void main() {
     fragTexCoord = inPosition;
     
     // mat4(mat3()) removes translation and scale
-    vec4 pos = t.proj * mat4(mat3(t.view)) * mat4(mat3(t.model)) * vec4(inPosition, 1.0); // Always in the center
+    vec4 pos = globals.proj * mat4(mat3(globals.view)) * mat4(mat3(t.model)) * vec4(inPosition, 1.0); // Always in the center
     gl_Position = pos.xyww;
 }
@@ -2,18 +2,22 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(binding = 0) uniform LocalTransform {
+layout(push_constant) uniform LocalTransform {
     mat4 model;
+} t;
+
+// Leading members of Globals, see shader.frag
+layout(set = 0, binding = 0) uniform Globals {
     mat4 view;
     mat4 proj;
     mat4 lightSpace;
-} t;
+} globals;
+
+#include "vertex_input.glsl"
 
 layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec4 inColor;
 layout(location = 3) in vec2 inTexCoord;
-layout(location = 4) in vec4 inTangent;
 
 layout(location = 0) out vec3 fragPos;
 layout(location = 1) out vec4 fragColor;
@@ -37,7 +41,7 @@ void main() {
     vec3 B = cross(T, N) * inTangent.w;
     fragTbn = mat3(T, B, N);
     
-    fragShadowCoord = t.lightSpace * vec4(fragPos, 1.0);
+    fragShadowCoord = globals.lightSpace * vec4(fragPos, 1.0);
     
-    gl_Position = t.proj * t.view * vec4(fragPos, 1.0);
+    gl_Position = globals.proj * globals.view * vec4(fragPos, 1.0);
 }
@@ -0,0 +1,26 @@
+// Normal and tangent inputs for both vertex formats, see VertexFormat in Vertex.hpp.
+// Shaders compiled with PACKED_VERTEX decode the octahedral normal and tangent of PackedVertex,
+// the other packed attributes are expanded by their Vulkan formats.
+
+#ifdef PACKED_VERTEX
+
+layout(location = 1) in vec2 inPackedNormal;
+layout(location = 4) in vec4 inPackedTangent; // xy: octahedral direction, z: bitangent sign
+
+vec3 decodeOctahedral(vec2 encoded) {
+    vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    if (direction.z < 0.0) {
+        direction.xy = (1.0 - abs(direction.yx)) * vec2(direction.x >= 0.0 ? 1.0 : -1.0, direction.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(direction);
+}
+
+#define inNormal decodeOctahedral(inPackedNormal)
+#define inTangent vec4(decodeOctahedral(inPackedTangent.xy), inPackedTangent.z)
+
+#else
+
+layout(location = 1) in vec3 inNormal;
+layout(location = 4) in vec4 inTangent;
+
+#endif
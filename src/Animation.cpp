@@ -1,41 +1,107 @@
 #include "Animation.hpp"
 
 Animation::Animation(std::string name, float duration, float ticksPerSecond)
-    : name(name), duration(duration), ticksPerSecond(ticksPerSecond), boneAnimationChannels() {}
+    : name(name), duration(duration), ticksPerSecond(ticksPerSecond), channels(), channelIndices() {}
 
 AnimationChannel& Animation::createChannel(std::string boneName) {
-    boneAnimationChannels[boneName] = AnimationChannel(boneName);
-    return boneAnimationChannels[boneName];
+    auto it = channelIndices.find(boneName);
+    if (it != channelIndices.end()) {
+        channels[it->second] = AnimationChannel(boneName);
+        return channels[it->second];
+    }
+    
+    channelIndices[boneName] = channels.size();
+    channels.push_back(AnimationChannel(boneName));
+    return channels.back();
 }
 
-inline AnimationChannel& Animation::getChannel(std::string boneName) {
-    if (!hasChannel(boneName)) {
+const AnimationChannel& Animation::getChannel(const std::string& boneName) const {
+    auto index = findChannel(boneName);
+    if (index < 0) {
         throw std::runtime_error("No animation channel named '" + boneName + "' exists.");
     }
     
-    return boneAnimationChannels[boneName];
+    return channels[index];
 }
 
-inline bool Animation::hasChannel(std::string boneName) {
-    return boneAnimationChannels.count(boneName) != 0;
+bool Animation::hasChannel(const std::string& boneName) const {
+    return channelIndices.count(boneName) != 0;
 }
 
-void Animation::evaluate(Mesh& mesh, Skeleton& skeleton, float time) {
-    float timeInTicks = time * ticksPerSecond;
-    float animationTime = fmod(timeInTicks, duration);
-    traverseBoneHierarchy(animationTime, skeleton.getRoot(), glm::mat4(1.0f), mesh.getBoneData(), mesh.getBoneTransforms());
+int32_t Animation::findChannel(const std::string& boneName) const {
+    auto it = channelIndices.find(boneName);
+    return it != channelIndices.end() ? static_cast<int32_t>(it->second) : -1;
+}
+
+size_t Animation::getKeyCount() const {
+    size_t keyCount = 0;
+    for (const auto& channel : channels) {
+        keyCount += channel.translationKeys.size() + channel.rotationKeys.size() + channel.scaleKeys.size();
+    }
+    return keyCount;
+}
+
+size_t Animation::getMemorySize() const {
+    size_t size = channels.size() * sizeof(AnimationChannel);
+    for (const auto& channel : channels) {
+        size += channel.translationKeys.size() * sizeof(Keyframe<glm::vec3>);
+        size += channel.rotationKeys.size() * sizeof(Keyframe<glm::quat>);
+        size += channel.scaleKeys.size() * sizeof(Keyframe<glm::vec3>);
+    }
+    return size;
+}
+
+void Animation::bind(const Skeleton& skeleton, AnimationSampler& sampler) const {
+    auto& joints = skeleton.getJoints();
+    sampler.animation = this;
+    
+    sampler.jointChannels.resize(joints.size());
+    for (size_t i = 0; i < joints.size(); i++) {
+        sampler.jointChannels[i] = findChannel(joints[i].name);
+    }
+    
+    sampler.cursors.assign(channels.size(), AnimationCursor());
+}
+
+void Animation::sample(const Skeleton& skeleton, float time, AnimationSampler& sampler, Pose& pose) const {
+    if (sampler.animation != this) {
+        bind(skeleton, sampler);
+    }
+
+    float animationTime = toAnimationTime(time);
+
+    auto& joints = skeleton.getJoints();
+    pose.joints.resize(joints.size());
+    
+    for (size_t i = 0; i < joints.size(); i++) {
+        auto& bindPose = joints[i].bindPose;
+        auto& jointPose = pose.joints[i];
+        
+        auto channelIndex = sampler.jointChannels[i];
+        if (channelIndex < 0 || (sampler.skipDetailJoints && joints[i].detail)) {
+            jointPose = bindPose;
+            continue;
+        }
+        
+        auto& channel = channels[channelIndex];
+        auto& cursor = sampler.cursors[channelIndex];
+        
+        jointPose.translation = calculateTranslation(channel, animationTime, cursor.translation, bindPose.translation);
+        jointPose.rotation = calculateRotation(channel, animationTime, cursor.rotation, bindPose.rotation);
+        jointPose.scale = calculateScale(channel, animationTime, cursor.scale, bindPose.scale);
+    }
 }
 
-glm::vec3 Animation::calculateTranslation(AnimationChannel& channel, float animationTime) {
+glm::vec3 Animation::calculateTranslation(const AnimationChannel& channel, float animationTime, size_t& cursor, glm::vec3 defaultValue) {
     if (channel.translationKeys.size() == 0) {
-        return glm::vec3();
+        return defaultValue;
     }
     
     if (channel.translationKeys.size() == 1) {
         return channel.translationKeys[0].value;
     }
     
-    auto currentIndex = channel.findTranslationIndex(animationTime);
+    auto currentIndex = AnimationChannel::findKeyIndex(channel.translationKeys, animationTime, cursor);
     auto nextIndex = (currentIndex + 1) % channel.translationKeys.size();
     
     auto& currentKey = channel.translationKeys[currentIndex];
@@ -48,16 +114,16 @@ glm::vec3 Animation::calculateTranslation(AnimationChannel& channel, float anima
     return glm::mix(currentKey.value, nextKey.value, relativeTime);
 }
 
-glm::quat Animation::calculateRotation(AnimationChannel& channel, float animationTime) {
+glm::quat Animation::calculateRotation(const AnimationChannel& channel, float animationTime, size_t& cursor, glm::quat defaultValue) {
     if (channel.rotationKeys.size() == 0) {
-        return glm::quat();
+        return defaultValue;
     }
     
     if (channel.rotationKeys.size() == 1) {
         return channel.rotationKeys[0].value;
     }
     
-    auto currentIndex = channel.findRotationIndex(animationTime);
+    auto currentIndex = AnimationChannel::findKeyIndex(channel.rotationKeys, animationTime, cursor);
     auto nextIndex = (currentIndex + 1) % channel.rotationKeys.size();
     
     auto& currentKey = channel.rotationKeys[currentIndex];
@@ -70,16 +136,16 @@ glm::quat Animation::calculateRotation(AnimationChannel& channel, float animatio
     return glm::mix(currentKey.value, nextKey.value, relativeTime);
 }
 
-glm::vec3 Animation::calculateScale(AnimationChannel& channel, float animationTime) {
+glm::vec3 Animation::calculateScale(const AnimationChannel& channel, float animationTime, size_t& cursor, glm::vec3 defaultValue) {
     if (channel.scaleKeys.size() == 0) {
-        return glm::vec3();
+        return defaultValue;
     }
     
     if (channel.scaleKeys.size() == 1) {
         return channel.scaleKeys[0].value;
     }
     
-    auto currentIndex = channel.findScaleIndex(animationTime);
+    auto currentIndex = AnimationChannel::findKeyIndex(channel.scaleKeys, animationTime, cursor);
     auto nextIndex = (currentIndex + 1) % channel.scaleKeys.size();
     
     auto& currentKey = channel.scaleKeys[currentIndex];
@@ -91,34 +157,3 @@ glm::vec3 Animation::calculateScale(AnimationChannel& channel, float animationTi
     
     return glm::mix(currentKey.value, nextKey.value, relativeTime);
 }
-
-void Animation::traverseBoneHierarchy(float animationTime, std::shared_ptr<Bone> bone, glm::mat4 parentTransform, std::unordered_map<std::string, MeshBoneData>& boneData, std::vector<glm::mat4>& boneTransforms)
-{
-    glm::mat4 boneTransformation = bone->transformation;
-    std::string& boneName = bone->name;
-    
-    if (hasChannel(boneName))
-    {
-        auto& animationChannel = getChannel(boneName);
-        
-        auto scale = calculateScale(animationChannel, animationTime);
-        auto rotation = calculateRotation(animationChannel, animationTime);
-        auto translation = calculateTranslation(animationChannel, animationTime);
-        
-        auto translationMatrix = glm::translate(glm::mat4(1.0f), translation);
-        auto rotationMatrix = glm::toMat4(rotation);
-        auto scaleMatrix = glm::scale(glm::mat4(1.0f), scale);
-        
-        boneTransformation = translationMatrix * rotationMatrix * scaleMatrix;
-    }
-    
-    glm::mat4 globalTransformation = parentTransform * boneTransformation;
-    
-    if (boneData.count(boneName) != 0) {
-        boneTransforms[boneData[boneName].index] = globalTransformation * boneData[boneName].offset;
-    }
-    
-    for (const auto& child : bone->children) {
-        traverseBoneHierarchy(animationTime, child, globalTransformation, boneData, boneTransforms);
-    }
-}
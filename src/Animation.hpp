@@ -2,6 +2,7 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 #include <unordered_map>
 
 #define GLM_FORCE_RADIANS
@@ -10,8 +11,10 @@
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtx/quaternion.hpp>
 
-#include "Mesh.hpp"
 #include "Skeleton.hpp"
+#include "Pose.hpp"
+
+class Animation;
 
 template <typename T>
 struct Keyframe {
@@ -21,6 +24,13 @@ struct Keyframe {
     Keyframe(float time, T value) : time(time), value(value) {}
 };
 
+/** Key positions of one channel from the previous evaluation, so sampling a playing clip rarely needs to search */
+struct AnimationCursor {
+    size_t translation = 0;
+    size_t rotation = 0;
+    size_t scale = 0;
+};
+
 struct AnimationChannel {
     std::string name;
     
@@ -43,62 +53,68 @@ struct AnimationChannel {
     AnimationChannel() : name("invalid") {}
     AnimationChannel(std::string name) : name(name) {}
     
-    size_t findTranslationIndex(float time) {
-        for (size_t i = 0; i < translationKeys.size(); i++) {
-            if (time < translationKeys[i + 1].time) {
-                return i;
-            }
+    template <typename T>
+    static size_t findKeyIndex(const std::vector<Keyframe<T>>& keys, float time, size_t& cursor) {
+        // Start from the cached key and only rewind when playback wrapped around or jumped backwards
+        if (cursor >= keys.size() || keys[cursor].time > time) {
+            cursor = 0;
         }
-        return 0;
-    }
-    
-    size_t findRotationIndex(float time) {
-        for (size_t i = 0; i < rotationKeys.size(); i++) {
-            if (time < rotationKeys[i + 1].time) {
-                return i;
-            }
-        }
-        return 0;
-    }
-    
-    size_t findScaleIndex(float time) {
-        for (size_t i = 0; i < scaleKeys.size(); i++) {
-            if (time < scaleKeys[i + 1].time) {
-                return i;
-            }
+        
+        while (cursor + 1 < keys.size() && keys[cursor + 1].time <= time) {
+            cursor++;
         }
-        return 0;
+        return cursor;
     }
 };
 
+/** Binding of one clip to a skeleton's joints plus its key cursors, owned by whoever plays the clip */
+struct AnimationSampler {
+    const Animation* animation = nullptr;
+    std::vector<int32_t> jointChannels; // -1 if the joint isn't animated by the clip
+    std::vector<AnimationCursor> cursors;
+    bool skipDetailJoints = false; // Leave the skeleton's detail joints in their bind pose
+};
+
+/** Immutable clip, shared by every model and instance that plays it. Playback state lives in AnimationState. */
 class Animation {
     
 public:
-    Animation() { throw std::runtime_error("Please call the other constructor."); } // Default constructor required for unordered_map
     Animation(std::string name, float duration, float ticksPerSecond);
     virtual ~Animation() {}
     
-    void evaluate(Mesh& mesh, Skeleton& skeleton, float time);
+    /** Samples the clip at the given time (in seconds) into a local-space pose, joints without a channel (or skipped detail joints) keep their bind pose */
+    virtual void sample(const Skeleton& skeleton, float time, AnimationSampler& sampler, Pose& pose) const;
+    
+    /** Bytes used by the key data, for memory reports */
+    virtual size_t getMemorySize() const;
     
     AnimationChannel& createChannel(std::string boneName);
-    AnimationChannel& getChannel(std::string boneName);
-    bool hasChannel(std::string boneName);
+    const AnimationChannel& getChannel(const std::string& boneName) const;
+    bool hasChannel(const std::string& boneName) const;
+    int32_t findChannel(const std::string& boneName) const;
+    const std::vector<AnimationChannel>& getChannels() const { return channels; }
+    size_t getKeyCount() const;
     
-    std::string getName() { return name; }
-    float getDuration() { return duration; }
-    float getTicksPerSecond() { return ticksPerSecond; }
+    std::string getName() const { return name; }
+    float getDuration() const { return duration; }
+    float getTicksPerSecond() const { return ticksPerSecond; }
+    
+protected:
+    void bind(const Skeleton& skeleton, AnimationSampler& sampler) const;
+    float toAnimationTime(float time) const { return fmod(time * ticksPerSecond, duration); }
     
 private:
     std::string name;
     float duration;
     float ticksPerSecond;
     
-    std::unordered_map<std::string, AnimationChannel> boneAnimationChannels;
-    
-    glm::vec3 calculateTranslation(AnimationChannel& channel, float animationTime);
-    glm::quat calculateRotation(AnimationChannel& channel, float animationTime);
-    glm::vec3 calculateScale(AnimationChannel& channel, float animationTime);
+    std::vector<AnimationChannel> channels;
+    std::unordered_map<std::string, size_t> channelIndices;
     
-    void traverseBoneHierarchy(float animationTime, std::shared_ptr<Bone> bone, glm::mat4 parentTransform, std::unordered_map<std::string, MeshBoneData>& boneData, std::vector<glm::mat4>& boneTransforms);
+    static glm::vec3 calculateTranslation(const AnimationChannel& channel, float animationTime, size_t& cursor, glm::vec3 defaultValue);
+    static glm::quat calculateRotation(const AnimationChannel& channel, float animationTime, size_t& cursor, glm::quat defaultValue);
+    static glm::vec3 calculateScale(const AnimationChannel& channel, float animationTime, size_t& cursor, glm::vec3 defaultValue);
     
 };
+
+using AnimationClips = std::unordered_map<std::string, std::shared_ptr<const Animation>>;
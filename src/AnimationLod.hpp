@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+struct AnimationLodLevel {
+    float distance; // Camera distance from which this level applies
+    uint32_t updateInterval; // Instances only update every n-th frame, staggered across instances
+};
+
+struct AnimationLodSettings {
+    // Sorted by distance, instances closer than the first level update every frame
+    std::vector<AnimationLodLevel> levels = { { 30.0f, 2 }, { 60.0f, 4 } };
+
+    // Fraction of the screen height below which the skeleton's detail joints (fingers, toes, ...) keep their bind pose
+    float detailJointScreenSize = 0.2f;
+};
+
+/** Per-frame animation counters, reset at the start of every frame */
+struct AnimationStats {
+    uint32_t updatedInstances;
+    uint32_t skippedInstances;
+    uint32_t evaluatedJoints;
+    uint32_t skippedJoints; // Detail joints left in their bind pose by instances that did update
+};
@@ -0,0 +1,85 @@
+#include "AnimationState.hpp"
+
+AnimationState::AnimationState(std::shared_ptr<const Skeleton> skeleton)
+        : skeleton(skeleton), time(0.0f), fadeStart(0.0f), fadeDuration(0.0f), interpolateBaked(true), skipDetailJoints(false) {
+    referencePose.setBindPose(*skeleton);
+    globalTransforms.resize(skeleton->getJointCount(), glm::mat4(1.0f));
+    palette.resize(skeleton->getPaletteSize(), glm::mat4(1.0f));
+}
+
+void AnimationState::play(std::shared_ptr<const Animation> clip, float time, float fadeDuration) {
+    baked = nullptr;
+
+    if (clip != current.clip) {
+        if (fadeDuration > 0.0f && current.clip != nullptr) {
+            // Swapping keeps the samplers' buffers around, so switching clips back and forth doesn't allocate
+            std::swap(previous, current);
+            fadeStart = time;
+            this->fadeDuration = fadeDuration;
+        } else {
+            previous.clip = nullptr;
+        }
+        current.clip = clip;
+    }
+
+    this->time = time;
+}
+
+void AnimationState::setAdditive(std::shared_ptr<const Animation> clip, float weight) {
+    additive.clip = clip;
+    additive.weight = weight;
+}
+
+void AnimationState::playBaked(std::shared_ptr<const BakedAnimation> clip, float time, bool interpolate) {
+    if (clip->getPaletteSize() != palette.size()) {
+        throw std::runtime_error("The baked animation '" + clip->getName() + "' was baked for a different skeleton.");
+    }
+
+    baked = clip;
+    interpolateBaked = interpolate;
+    current.clip = nullptr;
+    previous.clip = nullptr;
+    this->time = time;
+}
+
+uint32_t AnimationState::update(PosePool& pool) {
+    if (baked != nullptr) {
+        baked->evaluate(time, palette, interpolateBaked);
+        return 0;
+    }
+
+    if (current.clip == nullptr) {
+        return 0;
+    }
+
+    current.sampler.skipDetailJoints = skipDetailJoints;
+    previous.sampler.skipDetailJoints = skipDetailJoints;
+    additive.sampler.skipDetailJoints = skipDetailJoints;
+
+    auto jointCount = skeleton->getJointCount();
+    auto& pose = pool.acquire(jointCount);
+    current.clip->sample(*skeleton, time, current.sampler, pose);
+
+    if (previous.clip != nullptr) {
+        float weight = (time - fadeStart) / fadeDuration;
+
+        if (weight >= 1.0f || weight < 0.0f) {
+            previous.clip = nullptr;
+        } else {
+            auto& previousPose = pool.acquire(jointCount);
+            previous.clip->sample(*skeleton, time, previous.sampler, previousPose);
+            Pose::blend(previousPose, pose, weight, pose);
+        }
+    }
+
+    if (additive.clip != nullptr && additive.weight > 0.0f) {
+        auto& additivePose = pool.acquire(jointCount);
+        additive.clip->sample(*skeleton, time, additive.sampler, additivePose);
+        Pose::addAdditive(pose, additivePose, referencePose, additive.weight, pose);
+    }
+
+    pose.toModelSpace(*skeleton, globalTransforms, palette, skipDetailJoints);
+
+    auto skippedJoints = skipDetailJoints ? skeleton->getDetailJointCount() : 0;
+    return static_cast<uint32_t>(jointCount - skippedJoints);
+}
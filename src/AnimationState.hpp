@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "Animation.hpp"
+#include "BakedAnimation.hpp"
+#include "Skeleton.hpp"
+#include "Pose.hpp"
+
+struct AnimationLayer {
+    std::shared_ptr<const Animation> clip;
+    AnimationSampler sampler;
+    float weight = 1.0f;
+};
+
+/**
+ * Per-instance playback state: the playing clip, an optional clip being faded out, an optional additive layer and
+ * the resulting bone palette. Skeleton and clips are shared between instances, so this is all an additional animated
+ * instance costs.
+ */
+class AnimationState {
+
+public:
+    AnimationState(std::shared_ptr<const Skeleton> skeleton);
+
+    /** Switches to the given clip (cross-fading over fadeDuration seconds) and advances playback to time */
+    void play(std::shared_ptr<const Animation> clip, float time, float fadeDuration = 0.0f);
+    void setAdditive(std::shared_ptr<const Animation> clip, float weight);
+
+    /** Plays a pre-baked clip instead, update() then only copies or lerps stored palettes and ignores the layers */
+    void playBaked(std::shared_ptr<const BakedAnimation> clip, float time, bool interpolate = true);
+
+    /**
+     * Samples and blends all layers into pool poses, then builds the palette with one matrix composition per joint.
+     * Returns the number of joints that were evaluated.
+     */
+    uint32_t update(PosePool& pool);
+
+    /** Animation LOD: leaves the skeleton's detail joints in their bind pose while enabled */
+    void setSkipDetailJoints(bool skip) { skipDetailJoints = skip; }
+
+    const Skeleton& getSkeleton() const { return *skeleton; }
+    const std::shared_ptr<const Animation>& getClip() const { return current.clip; }
+    float getTime() const { return time; }
+    bool isFading() const { return previous.clip != nullptr; }
+    bool isBaked() const { return baked != nullptr; }
+    const std::vector<glm::mat4>& getPalette() const { return palette; }
+
+private:
+    std::shared_ptr<const Skeleton> skeleton;
+    float time;
+
+    AnimationLayer current;
+    AnimationLayer previous;
+    AnimationLayer additive;
+    float fadeStart;
+    float fadeDuration;
+
+    std::shared_ptr<const BakedAnimation> baked;
+    bool interpolateBaked;
+    bool skipDetailJoints;
+
+    Pose referencePose;
+    std::vector<glm::mat4> globalTransforms;
+    std::vector<glm::mat4> palette;
+
+};
@@ -0,0 +1,81 @@
+#include "BakedAnimation.hpp"
+
+#include <cmath>
+#include <cstring>
+
+std::shared_ptr<const BakedAnimation> BakedAnimation::bake(const Animation& clip, const Skeleton& skeleton, float sampleRate) {
+    if (sampleRate <= 0.0f) {
+        throw std::runtime_error("The sample rate for baking '" + clip.getName() + "' must be positive.");
+    }
+
+    auto duration = getDurationInSeconds(clip);
+    auto frameCount = getFrameCount(duration, sampleRate);
+    auto paletteSize = skeleton.getPaletteSize();
+
+    auto baked = std::shared_ptr<BakedAnimation>(new BakedAnimation(clip.getName(), sampleRate, duration, frameCount, paletteSize));
+    baked->palettes.resize(frameCount * paletteSize, glm::mat4(1.0f));
+
+    AnimationSampler sampler;
+    Pose pose;
+    std::vector<glm::mat4> globalTransforms(skeleton.getJointCount(), glm::mat4(1.0f));
+    std::vector<glm::mat4> palette(paletteSize, glm::mat4(1.0f));
+
+    for (uint32_t frame = 0; frame < frameCount; frame++) {
+        // Frames are spread evenly over the clip. The last one lands on its end, which wraps to the first pose, so
+        // interpolation loops seamlessly.
+        float time = frameCount > 1 ? duration * frame / (frameCount - 1) : 0.0f;
+        clip.sample(skeleton, time, sampler, pose);
+        pose.toModelSpace(skeleton, globalTransforms, palette);
+        std::copy(palette.begin(), palette.end(), baked->palettes.begin() + frame * paletteSize);
+    }
+
+    return baked;
+}
+
+size_t BakedAnimation::estimateMemorySize(const Animation& clip, const Skeleton& skeleton, float sampleRate) {
+    return getFrameCount(getDurationInSeconds(clip), sampleRate) * skeleton.getPaletteSize() * sizeof(glm::mat4);
+}
+
+void BakedAnimation::evaluate(float time, std::vector<glm::mat4>& palette, bool interpolate) const {
+    palette.resize(paletteSize);
+    if (paletteSize == 0) {
+        return;
+    }
+
+    float position = 0.0f;
+    if (duration > 0.0f) {
+        float clipTime = std::fmod(time, duration);
+        if (clipTime < 0.0f) {
+            clipTime += duration;
+        }
+        position = clipTime / duration * (frameCount - 1);
+    }
+
+    auto frame = std::min(static_cast<uint32_t>(position), frameCount - 1);
+    auto nextFrame = std::min(frame + 1, frameCount - 1);
+    float weight = position - frame;
+
+    if (!interpolate || frame == nextFrame) {
+        auto nearestFrame = weight >= 0.5f ? nextFrame : frame;
+        std::memcpy(palette.data(), palettes.data() + nearestFrame * paletteSize, paletteSize * sizeof(glm::mat4));
+        return;
+    }
+
+    auto current = palettes.data() + frame * paletteSize;
+    auto next = palettes.data() + nextFrame * paletteSize;
+    for (size_t i = 0; i < paletteSize; i++) {
+        // Frames are close together, so lerping the matrices directly is visually indistinguishable from blending poses
+        for (int column = 0; column < 4; column++) {
+            palette[i][column] = glm::mix(current[i][column], next[i][column], weight);
+        }
+    }
+}
+
+float BakedAnimation::getDurationInSeconds(const Animation& clip) {
+    return clip.getTicksPerSecond() > 0.0f ? clip.getDuration() / clip.getTicksPerSecond() : clip.getDuration();
+}
+
+uint32_t BakedAnimation::getFrameCount(float duration, float sampleRate) {
+    // One extra frame at the end of the clip to interpolate towards when looping
+    return static_cast<uint32_t>(std::ceil(duration * sampleRate)) + 1;
+}
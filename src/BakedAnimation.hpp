@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include "Animation.hpp"
+#include "Skeleton.hpp"
+
+/**
+ * Clip pre-sampled into bone palettes at a fixed rate for one skeleton, stored frame after frame in a single buffer.
+ * Playback is a copy or a lerp of two stored palettes, so it suits background characters that don't blend clips.
+ */
+class BakedAnimation {
+
+public:
+    static std::shared_ptr<const BakedAnimation> bake(const Animation& clip, const Skeleton& skeleton, float sampleRate = 30.0f);
+
+    /** Bytes a baked version of the clip would take, to decide which clips are worth baking */
+    static size_t estimateMemorySize(const Animation& clip, const Skeleton& skeleton, float sampleRate = 30.0f);
+
+    /** Writes the palette at the given time (in seconds), either snapped to the nearest frame or interpolated */
+    void evaluate(float time, std::vector<glm::mat4>& palette, bool interpolate = true) const;
+
+    size_t getMemorySize() const { return palettes.size() * sizeof(glm::mat4); }
+    std::string getName() const { return name; }
+    float getSampleRate() const { return sampleRate; }
+    uint32_t getFrameCount() const { return frameCount; }
+    size_t getPaletteSize() const { return paletteSize; }
+
+private:
+    std::string name;
+    float sampleRate;
+    float duration; // In seconds
+    uint32_t frameCount;
+    size_t paletteSize;
+
+    // frameCount palettes of paletteSize matrices each
+    std::vector<glm::mat4> palettes;
+
+    BakedAnimation(std::string name, float sampleRate, float duration, uint32_t frameCount, size_t paletteSize)
+        : name(name), sampleRate(sampleRate), duration(duration), frameCount(frameCount), paletteSize(paletteSize) {}
+
+    static float getDurationInSeconds(const Animation& clip);
+    static uint32_t getFrameCount(float duration, float sampleRate);
+
+};
+
+using BakedAnimationClips = std::unordered_map<std::string, std::shared_ptr<const BakedAnimation>>;
@@ -0,0 +1,168 @@
+#include "BindlessResources.hpp"
+
+#include <array>
+#include <stdexcept>
+
+#include "VulkanDevice.hpp"
+#include "VulkanTexture.hpp"
+#include "Pipeline.hpp"
+
+BindlessResources::BindlessResources(VulkanDevice& device) : device(device) {
+    device.createBuffer(sizeof(Material) * MAX_MATERIALS, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, materialBuffer, MemoryCategory::Uniform);
+
+    createDescriptorSetLayout();
+    createDescriptorSet();
+}
+
+BindlessResources::~BindlessResources() {
+    // Textures only referenced by materials are destroyed here, while the device's memory allocator still exists
+    materialTextures.clear();
+
+    vkDestroyDescriptorPool(device.device, descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(device.device, descriptorSetLayout, nullptr);
+    device.freeBuffer(materialBuffer);
+}
+
+void BindlessResources::createDescriptorSetLayout() {
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings = {};
+
+    bindings[0].binding = 0;
+    bindings[0].descriptorCount = MAX_TEXTURES;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].pImmutableSamplers = nullptr;
+    bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    bindings[1].binding = 1;
+    bindings[1].descriptorCount = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[1].pImmutableSamplers = nullptr;
+    bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    // Unused slots stay empty, new textures are written while earlier frames using the set are still in flight
+    std::array<VkDescriptorBindingFlagsEXT, 2> bindingFlags = {
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT,
+        0
+    };
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo = {};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+    bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+    bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = &bindingFlagsInfo;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(device.device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor set layout!");
+    }
+}
+
+void BindlessResources::createDescriptorSet() {
+    std::array<VkDescriptorPoolSize, 2> poolSizes = {};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[0].descriptorCount = MAX_TEXTURES;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[1].descriptorCount = 1;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = 1;
+
+    if (vkCreateDescriptorPool(device.device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor pool!");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &descriptorSetLayout;
+
+    if (vkAllocateDescriptorSets(device.device, &allocInfo, &descriptorSet) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate descriptor sets!");
+    }
+
+    VkDescriptorBufferInfo materialInfo = {};
+    materialInfo.buffer = materialBuffer.buffer;
+    materialInfo.offset = 0;
+    materialInfo.range = sizeof(Material) * MAX_MATERIALS;
+
+    VkWriteDescriptorSet descriptorWrite = {};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = descriptorSet;
+    descriptorWrite.dstBinding = 1;
+    descriptorWrite.dstArrayElement = 0;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pBufferInfo = &materialInfo;
+
+    vkUpdateDescriptorSets(device.device, 1, &descriptorWrite, 0, nullptr);
+}
+
+uint32_t BindlessResources::registerTexture(const VkDescriptorImageInfo& imageInfo) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    uint32_t index;
+    if (!freeTextureSlots.empty()) {
+        index = freeTextureSlots.back();
+        freeTextureSlots.pop_back();
+    } else if (textureCount < MAX_TEXTURES) {
+        index = textureCount++;
+    } else {
+        throw std::runtime_error("The bindless texture array is full.");
+    }
+
+    VkWriteDescriptorSet descriptorWrite = {};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = descriptorSet;
+    descriptorWrite.dstBinding = 0;
+    descriptorWrite.dstArrayElement = index;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(device.device, 1, &descriptorWrite, 0, nullptr);
+    return index;
+}
+
+void BindlessResources::unregisterTexture(uint32_t index) {
+    std::lock_guard<std::mutex> lock(mutex);
+    freeTextureSlots.push_back(index);
+}
+
+uint32_t BindlessResources::addMaterial(std::shared_ptr<VulkanTexture> albedo, std::shared_ptr<VulkanTexture> mask, std::shared_ptr<VulkanTexture> normalMap) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (materialCount >= MAX_MATERIALS) {
+        throw std::runtime_error("The bindless material table is full.");
+    }
+
+    Material material = {};
+    material.albedoTexture = albedo->getBindlessIndex();
+    material.maskTexture = mask->getBindlessIndex();
+    material.normalMapTexture = normalMap->getBindlessIndex();
+    if (material.albedoTexture == INVALID_INDEX || material.maskTexture == INVALID_INDEX || material.normalMapTexture == INVALID_INDEX) {
+        throw std::runtime_error("Materials can only reference registered 2D textures.");
+    }
+
+    // The entry hasn't been used by any frame yet, so it can be written while others are in flight
+    auto index = materialCount++;
+    static_cast<Material*>(materialBuffer.allocation.mapped)[index] = material;
+
+    materialTextures.push_back(std::move(albedo));
+    materialTextures.push_back(std::move(mask));
+    materialTextures.push_back(std::move(normalMap));
+    return index;
+}
+
+void BindlessResources::bind(VkCommandBuffer commandBuffer, Pipeline& pipeline) {
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getLayout(), SET_INDEX, 1, &descriptorSet, 0, nullptr);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "VulkanBuffer.hpp"
+
+class VulkanDevice;
+class VulkanTexture;
+class Pipeline;
+
+/** Indices of a material's textures in the bindless texture array, laid out like the std430 struct in the shaders */
+struct Material {
+    uint32_t albedoTexture;
+    uint32_t maskTexture;
+    uint32_t normalMapTexture;
+};
+
+/**
+ * Descriptor set 2 in bindless mode (requires VK_EXT_descriptor_indexing): every 2D VulkanTexture is registered in one
+ * large sampled image array at binding 0, materials are stored as texture indices in a storage buffer at binding 1.
+ * Draws only select their material with an index, so models with different materials don't need different sets.
+ */
+class BindlessResources {
+
+public:
+    explicit BindlessResources(VulkanDevice& device);
+    virtual ~BindlessResources();
+
+    /** Writes the texture into a free slot of the array and returns its index */
+    uint32_t registerTexture(const VkDescriptorImageInfo& imageInfo);
+    /** The slot may be reused right away, so the texture must no longer be drawn with */
+    void unregisterTexture(uint32_t index);
+
+    /** Keeps the textures alive as long as the table and returns the material's index */
+    uint32_t addMaterial(std::shared_ptr<VulkanTexture> albedo, std::shared_ptr<VulkanTexture> mask, std::shared_ptr<VulkanTexture> normalMap);
+
+    void bind(VkCommandBuffer commandBuffer, Pipeline& pipeline);
+
+    VkDescriptorSetLayout getDescriptorSetLayout() { return descriptorSetLayout; }
+    uint32_t getTextureCount() const { return textureCount - static_cast<uint32_t>(freeTextureSlots.size()); }
+    uint32_t getMaterialCount() const { return materialCount; }
+
+    static const uint32_t SET_INDEX = 2;
+    static const uint32_t MAX_TEXTURES = 4096;
+    static const uint32_t MAX_MATERIALS = 1024;
+    static const uint32_t INVALID_INDEX = ~0u;
+
+private:
+    VulkanDevice& device;
+
+    VkDescriptorSetLayout descriptorSetLayout;
+    VkDescriptorPool descriptorPool;
+    VkDescriptorSet descriptorSet;
+
+    VulkanBuffer materialBuffer; // Persistently mapped, MAX_MATERIALS entries
+    uint32_t materialCount = 0;
+    std::vector<std::shared_ptr<VulkanTexture>> materialTextures;
+
+    uint32_t textureCount = 0; // Slots handed out so far, including freed ones
+    std::vector<uint32_t> freeTextureSlots;
+    std::mutex mutex;
+
+    void createDescriptorSetLayout();
+    void createDescriptorSet();
+
+};
@@ -0,0 +1,306 @@
+#include "CompressedAnimation.hpp"
+
+#include <cstring>
+#include <cmath>
+
+// Smallest-three encoding: the three smaller components of a unit quaternion lie within +-1/sqrt(2)
+static const float ROTATION_COMPONENT_RANGE = 0.70710678f;
+static const uint32_t ROTATION_COMPONENT_MAX = (1 << 15) - 1;
+static const float VALUE_MAX = 65535.0f;
+
+std::shared_ptr<const CompressedAnimation> CompressedAnimation::compress(const Animation& animation, const AnimationCompressionSettings& settings) {
+    auto compressed = std::shared_ptr<CompressedAnimation>(new CompressedAnimation(animation.getName(), animation.getDuration(), animation.getTicksPerSecond()));
+
+    auto vectorDistance = [](const glm::vec3& a, const glm::vec3& b) {
+        return glm::length(a - b);
+    };
+    auto rotationDistance = [](const glm::quat& a, const glm::quat& b) {
+        return 2.0f * std::acos(glm::min(std::fabs(glm::dot(glm::normalize(a), glm::normalize(b))), 1.0f));
+    };
+
+    auto& channels = animation.getChannels();
+    compressed->data.resize(channels.size() * TRACK_COUNT * sizeof(TrackHeader));
+
+    for (size_t i = 0; i < channels.size(); i++) {
+        auto& channel = channels[i];
+        compressed->createChannel(channel.name);
+
+        compressed->appendVectorTrack(i, TRACK_TRANSLATION, reduceKeys(channel.translationKeys, settings.translationTolerance, vectorDistance));
+        compressed->appendRotationTrack(i, reduceKeys(channel.rotationKeys, settings.rotationTolerance, rotationDistance));
+        compressed->appendVectorTrack(i, TRACK_SCALE, reduceKeys(channel.scaleKeys, settings.scaleTolerance, vectorDistance));
+    }
+
+    compressed->data.shrink_to_fit();
+    return compressed;
+}
+
+size_t CompressedAnimation::getMemorySize() const {
+    return data.size() + getChannels().size() * sizeof(AnimationChannel);
+}
+
+size_t CompressedAnimation::getCompressedKeyCount() const {
+    size_t keyCount = 0;
+    for (size_t i = 0; i < getChannels().size(); i++) {
+        keyCount += getTrack(i, TRACK_TRANSLATION).keyCount + getTrack(i, TRACK_ROTATION).keyCount + getTrack(i, TRACK_SCALE).keyCount;
+    }
+    return keyCount;
+}
+
+void CompressedAnimation::sample(const Skeleton& skeleton, float time, AnimationSampler& sampler, Pose& pose) const {
+    if (sampler.animation != this) {
+        bind(skeleton, sampler);
+    }
+
+    float animationTime = toAnimationTime(time);
+
+    auto& joints = skeleton.getJoints();
+    pose.joints.resize(joints.size());
+
+    for (size_t i = 0; i < joints.size(); i++) {
+        auto& bindPose = joints[i].bindPose;
+        auto& jointPose = pose.joints[i];
+
+        auto channelIndex = sampler.jointChannels[i];
+        if (channelIndex < 0 || (sampler.skipDetailJoints && joints[i].detail)) {
+            jointPose = bindPose;
+            continue;
+        }
+
+        auto& cursor = sampler.cursors[channelIndex];
+
+        jointPose.translation = sampleVectorTrack(getTrack(channelIndex, TRACK_TRANSLATION), animationTime, cursor.translation, bindPose.translation);
+        jointPose.rotation = sampleRotationTrack(getTrack(channelIndex, TRACK_ROTATION), animationTime, cursor.rotation, bindPose.rotation);
+        jointPose.scale = sampleVectorTrack(getTrack(channelIndex, TRACK_SCALE), animationTime, cursor.scale, bindPose.scale);
+    }
+}
+
+size_t CompressedAnimation::findKeyIndex(const TrackHeader& track, float animationTime, size_t& cursor) const {
+    auto times = getTimes(track);
+
+    if (cursor >= track.keyCount || dequantizeTime(times[cursor]) > animationTime) {
+        cursor = 0;
+    }
+
+    while (cursor + 1 < track.keyCount && dequantizeTime(times[cursor + 1]) <= animationTime) {
+        cursor++;
+    }
+    return cursor;
+}
+
+float CompressedAnimation::interpolationFactor(const TrackHeader& track, size_t currentIndex, size_t nextIndex, float animationTime) const {
+    auto times = getTimes(track);
+    float currentTime = dequantizeTime(times[currentIndex]);
+    float deltaTime = dequantizeTime(times[nextIndex]) - currentTime;
+
+    if (deltaTime <= 0.0f) {
+        return 0.0f;
+    }
+    return glm::clamp((animationTime - currentTime) / deltaTime, 0.0f, 1.0f);
+}
+
+glm::vec3 CompressedAnimation::sampleVectorTrack(const TrackHeader& track, float animationTime, size_t& cursor, glm::vec3 defaultValue) const {
+    if (track.keyCount == 0) {
+        return defaultValue;
+    }
+
+    auto values = getValues(track);
+    auto decode = [&](size_t index) {
+        auto value = values + index * 3;
+        return glm::vec3(
+            track.rangeMin[0] + value[0] / VALUE_MAX * track.rangeExtent[0],
+            track.rangeMin[1] + value[1] / VALUE_MAX * track.rangeExtent[1],
+            track.rangeMin[2] + value[2] / VALUE_MAX * track.rangeExtent[2]
+        );
+    };
+
+    if (track.keyCount == 1) {
+        return decode(0);
+    }
+
+    auto currentIndex = findKeyIndex(track, animationTime, cursor);
+    auto nextIndex = (currentIndex + 1) % track.keyCount;
+
+    return glm::mix(decode(currentIndex), decode(nextIndex), interpolationFactor(track, currentIndex, nextIndex, animationTime));
+}
+
+glm::quat CompressedAnimation::sampleRotationTrack(const TrackHeader& track, float animationTime, size_t& cursor, glm::quat defaultValue) const {
+    if (track.keyCount == 0) {
+        return defaultValue;
+    }
+
+    auto values = getValues(track);
+    if (track.keyCount == 1) {
+        return decodeRotation(values);
+    }
+
+    auto currentIndex = findKeyIndex(track, animationTime, cursor);
+    auto nextIndex = (currentIndex + 1) % track.keyCount;
+
+    auto currentValue = decodeRotation(values + currentIndex * 3);
+    auto nextValue = decodeRotation(values + nextIndex * 3);
+
+    // Encoding picks the sign of each key independently, keep neighbouring keys in the same hemisphere
+    if (glm::dot(currentValue, nextValue) < 0.0f) {
+        nextValue = -nextValue;
+    }
+    return glm::mix(currentValue, nextValue, interpolationFactor(track, currentIndex, nextIndex, animationTime));
+}
+
+template <typename T, typename TDistance>
+std::vector<Keyframe<T>> CompressedAnimation::reduceKeys(const std::vector<Keyframe<T>>& keys, float tolerance, TDistance distance) {
+    if (keys.size() <= 1) {
+        return keys;
+    }
+
+    std::vector<Keyframe<T>> result = { keys[0] };
+    size_t last = 0;
+
+    for (size_t i = 1; i + 1 < keys.size(); i++) {
+        // Key i is redundant if interpolating from the last kept key to key i + 1 reproduces every key in between
+        auto& start = keys[last];
+        auto& end = keys[i + 1];
+        float deltaTime = end.time - start.time;
+
+        bool redundant = true;
+        for (size_t j = last + 1; j <= i && redundant; j++) {
+            float t = deltaTime > 0.0f ? (keys[j].time - start.time) / deltaTime : 0.0f;
+            redundant = distance(glm::mix(start.value, end.value, t), keys[j].value) <= tolerance;
+        }
+
+        if (!redundant) {
+            result.push_back(keys[i]);
+            last = i;
+        }
+    }
+
+    result.push_back(keys.back());
+
+    // Constant tracks only need a single key
+    if (result.size() == 2 && distance(result[0].value, result[1].value) <= tolerance) {
+        result.pop_back();
+    }
+    return result;
+}
+
+void CompressedAnimation::appendVectorTrack(size_t channel, TrackType type, const std::vector<Keyframe<glm::vec3>>& keys) {
+    TrackHeader track = {};
+    track.keyCount = static_cast<uint32_t>(keys.size());
+
+    glm::vec3 minValue(0.0f);
+    glm::vec3 maxValue(0.0f);
+    if (!keys.empty()) {
+        minValue = maxValue = keys[0].value;
+        for (const auto& key : keys) {
+            minValue = glm::min(minValue, key.value);
+            maxValue = glm::max(maxValue, key.value);
+        }
+    }
+
+    auto extent = maxValue - minValue;
+    for (int i = 0; i < 3; i++) {
+        track.rangeMin[i] = minValue[i];
+        track.rangeExtent[i] = extent[i];
+    }
+
+    std::vector<uint16_t> times;
+    std::vector<uint16_t> values;
+    for (const auto& key : keys) {
+        times.push_back(quantizeTime(key.time));
+
+        for (int i = 0; i < 3; i++) {
+            float normalized = extent[i] > 0.0f ? (key.value[i] - minValue[i]) / extent[i] : 0.0f;
+            values.push_back(static_cast<uint16_t>(std::round(glm::clamp(normalized, 0.0f, 1.0f) * VALUE_MAX)));
+        }
+    }
+
+    appendKeys(track, times, values);
+    std::memcpy(data.data() + (channel * TRACK_COUNT + type) * sizeof(TrackHeader), &track, sizeof(TrackHeader));
+}
+
+void CompressedAnimation::appendRotationTrack(size_t channel, const std::vector<Keyframe<glm::quat>>& keys) {
+    TrackHeader track = {};
+    track.keyCount = static_cast<uint32_t>(keys.size());
+
+    std::vector<uint16_t> times;
+    std::vector<uint16_t> values(keys.size() * 3);
+    for (size_t i = 0; i < keys.size(); i++) {
+        times.push_back(quantizeTime(keys[i].time));
+        encodeRotation(keys[i].value, &values[i * 3]);
+    }
+
+    appendKeys(track, times, values);
+    std::memcpy(data.data() + (channel * TRACK_COUNT + TRACK_ROTATION) * sizeof(TrackHeader), &track, sizeof(TrackHeader));
+}
+
+void CompressedAnimation::appendKeys(TrackHeader& track, const std::vector<uint16_t>& times, const std::vector<uint16_t>& values) {
+    track.timesOffset = static_cast<uint32_t>(data.size());
+    data.insert(data.end(), reinterpret_cast<const uint8_t*>(times.data()), reinterpret_cast<const uint8_t*>(times.data() + times.size()));
+
+    track.valuesOffset = static_cast<uint32_t>(data.size());
+    data.insert(data.end(), reinterpret_cast<const uint8_t*>(values.data()), reinterpret_cast<const uint8_t*>(values.data() + values.size()));
+}
+
+uint16_t CompressedAnimation::quantizeTime(float time) const {
+    if (getDuration() <= 0.0f) {
+        return 0;
+    }
+    return static_cast<uint16_t>(std::round(glm::clamp(time / getDuration(), 0.0f, 1.0f) * VALUE_MAX));
+}
+
+float CompressedAnimation::dequantizeTime(uint16_t time) const {
+    return time / VALUE_MAX * getDuration();
+}
+
+void CompressedAnimation::encodeRotation(glm::quat rotation, uint16_t* out) {
+    rotation = glm::normalize(rotation);
+    float components[4] = { rotation.x, rotation.y, rotation.z, rotation.w };
+
+    uint32_t largest = 0;
+    for (uint32_t i = 1; i < 4; i++) {
+        if (std::fabs(components[i]) > std::fabs(components[largest])) {
+            largest = i;
+        }
+    }
+
+    // q and -q are the same rotation, flip so the dropped component is positive and can be reconstructed
+    float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+
+    // 2 bits for the index of the dropped component, then 15 bits per remaining component
+    uint64_t packed = largest;
+    for (uint32_t i = 0; i < 4; i++) {
+        if (i == largest) {
+            continue;
+        }
+
+        float normalized = components[i] * sign / ROTATION_COMPONENT_RANGE * 0.5f + 0.5f;
+        auto quantized = static_cast<uint64_t>(std::round(glm::clamp(normalized, 0.0f, 1.0f) * ROTATION_COMPONENT_MAX));
+        packed = (packed << 15) | quantized;
+    }
+
+    out[0] = static_cast<uint16_t>(packed >> 32);
+    out[1] = static_cast<uint16_t>(packed >> 16);
+    out[2] = static_cast<uint16_t>(packed);
+}
+
+glm::quat CompressedAnimation::decodeRotation(const uint16_t* in) {
+    uint64_t packed = (static_cast<uint64_t>(in[0]) << 32) | (static_cast<uint64_t>(in[1]) << 16) | in[2];
+    uint32_t largest = static_cast<uint32_t>(packed >> 45) & 3;
+
+    float components[4];
+    float sumOfSquares = 0.0f;
+    int shift = 0;
+
+    for (int i = 3; i >= 0; i--) {
+        if (i == static_cast<int>(largest)) {
+            continue;
+        }
+
+        auto quantized = static_cast<uint32_t>(packed >> shift) & ROTATION_COMPONENT_MAX;
+        components[i] = (quantized / static_cast<float>(ROTATION_COMPONENT_MAX) - 0.5f) * 2.0f * ROTATION_COMPONENT_RANGE;
+        sumOfSquares += components[i] * components[i];
+        shift += 15;
+    }
+
+    components[largest] = std::sqrt(glm::max(1.0f - sumOfSquares, 0.0f));
+    return glm::quat(components[3], components[0], components[1], components[2]);
+}
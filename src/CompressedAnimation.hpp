@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "Animation.hpp"
+
+struct AnimationCompressionSettings {
+    float translationTolerance = 0.0005f;
+    float rotationTolerance = 0.0005f; // In radians
+    float scaleTolerance = 0.0005f;
+};
+
+/**
+ * Clip with redundant keys removed and the remaining keys quantized into one contiguous blob:
+ * 16-bit key times, smallest-three 48-bit rotations and 16-bit range-relative translations/scales.
+ */
+class CompressedAnimation : public Animation {
+
+public:
+    static std::shared_ptr<const CompressedAnimation> compress(const Animation& animation, const AnimationCompressionSettings& settings = AnimationCompressionSettings());
+
+    void sample(const Skeleton& skeleton, float time, AnimationSampler& sampler, Pose& pose) const override;
+    size_t getMemorySize() const override;
+    size_t getCompressedKeyCount() const;
+
+private:
+    enum TrackType {
+        TRACK_TRANSLATION = 0,
+        TRACK_ROTATION = 1,
+        TRACK_SCALE = 2,
+        TRACK_COUNT = 3
+    };
+
+    struct TrackHeader {
+        uint32_t keyCount;
+        uint32_t timesOffset; // Byte offsets into data, each key time is a uint16_t and each value three uint16_ts
+        uint32_t valuesOffset;
+        float rangeMin[3];
+        float rangeExtent[3];
+    };
+
+    // Track headers for all channels (TRACK_COUNT per channel), followed by the key data
+    std::vector<uint8_t> data;
+
+    CompressedAnimation(std::string name, float duration, float ticksPerSecond) : Animation(name, duration, ticksPerSecond) {}
+
+    const TrackHeader& getTrack(size_t channel, TrackType type) const {
+        return reinterpret_cast<const TrackHeader*>(data.data())[channel * TRACK_COUNT + type];
+    }
+
+    const uint16_t* getTimes(const TrackHeader& track) const { return reinterpret_cast<const uint16_t*>(data.data() + track.timesOffset); }
+    const uint16_t* getValues(const TrackHeader& track) const { return reinterpret_cast<const uint16_t*>(data.data() + track.valuesOffset); }
+
+    size_t findKeyIndex(const TrackHeader& track, float animationTime, size_t& cursor) const;
+    float interpolationFactor(const TrackHeader& track, size_t currentIndex, size_t nextIndex, float animationTime) const;
+
+    glm::vec3 sampleVectorTrack(const TrackHeader& track, float animationTime, size_t& cursor, glm::vec3 defaultValue) const;
+    glm::quat sampleRotationTrack(const TrackHeader& track, float animationTime, size_t& cursor, glm::quat defaultValue) const;
+
+    template <typename T, typename TDistance>
+    static std::vector<Keyframe<T>> reduceKeys(const std::vector<Keyframe<T>>& keys, float tolerance, TDistance distance);
+
+    void appendVectorTrack(size_t channel, TrackType type, const std::vector<Keyframe<glm::vec3>>& keys);
+    void appendRotationTrack(size_t channel, const std::vector<Keyframe<glm::quat>>& keys);
+    void appendKeys(TrackHeader& track, const std::vector<uint16_t>& times, const std::vector<uint16_t>& values);
+    uint16_t quantizeTime(float time) const;
+    float dequantizeTime(uint16_t time) const;
+
+    static void encodeRotation(glm::quat rotation, uint16_t* out);
+    static glm::quat decodeRotation(const uint16_t* in);
+
+};
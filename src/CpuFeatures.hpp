@@ -0,0 +1,19 @@
+#pragma once
+
+// SIMD kernels are compiled for their instruction set per function and only called after checking the CPU at runtime,
+// so the rest of the program keeps the baseline instruction set and floating-point results
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CPU_AVX2_KERNELS
+#define CPU_AVX2_FUNCTION __attribute__((target("avx2,fma")))
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define CPU_AVX2_KERNELS
+#define CPU_AVX2_FUNCTION // MSVC allows AVX2 intrinsics without /arch:AVX2
+#endif
+
+class CpuFeatures {
+
+public:
+    /** Whether the CPU and OS support AVX2 and FMA, checked once */
+    static bool hasAvx2();
+
+};
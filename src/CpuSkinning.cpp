@@ -0,0 +1,220 @@
+#include "CpuSkinning.hpp"
+
+#include <thread>
+#include <stdexcept>
+#include <algorithm>
+
+#ifdef CPU_AVX2_KERNELS
+#include <immintrin.h>
+#endif
+
+SkinningInput CpuSkinning::createInput(const std::vector<Vertex>& vertices) {
+    SkinningInput input;
+    input.vertexCount = vertices.size();
+
+    for (int c = 0; c < 3; c++) {
+        input.positions[c].resize(vertices.size());
+        input.normals[c].resize(vertices.size());
+        input.tangents[c].resize(vertices.size());
+    }
+    for (size_t b = 0; b < Vertex::BONES_PER_VERTEX; b++) {
+        input.boneIds[b].resize(vertices.size());
+        input.boneWeights[b].resize(vertices.size());
+    }
+
+    for (size_t i = 0; i < vertices.size(); i++) {
+        auto& vertex = vertices[i];
+
+        for (int c = 0; c < 3; c++) {
+            input.positions[c][i] = vertex.pos[c];
+            input.normals[c][i] = vertex.normal[c];
+            input.tangents[c][i] = vertex.tangent[c];
+        }
+
+        for (size_t b = 0; b < Vertex::BONES_PER_VERTEX; b++) {
+            // Unused influences point at bone 0, so the kernel never reads past the palette
+            bool used = vertex.boneWeights[b] != 0.0f;
+            input.boneIds[b][i] = used ? static_cast<int32_t>(vertex.boneIds[b]) : 0;
+            input.boneWeights[b][i] = used ? vertex.boneWeights[b] : 0.0f;
+
+            if (used) {
+                input.maxBoneId = std::max(input.maxBoneId, vertex.boneIds[b]);
+            }
+        }
+    }
+
+    return input;
+}
+
+void CpuSkinning::skin(const SkinningInput& input, const std::vector<glm::mat4>& palette, SkinningOutput& output, uint32_t threadCount) {
+    if (input.vertexCount > 0 && input.maxBoneId >= palette.size()) {
+        throw std::runtime_error("The bone palette is too small for the skinned vertices.");
+    }
+
+    output.vertexCount = input.vertexCount;
+    for (int c = 0; c < 3; c++) {
+        output.positions[c].resize(input.vertexCount);
+        output.normals[c].resize(input.vertexCount);
+        output.tangents[c].resize(input.vertexCount);
+    }
+
+    auto paletteData = reinterpret_cast<const float*>(palette.data());
+    auto useAvx2 = CpuFeatures::hasAvx2();
+    auto skinChunk = [&](size_t begin, size_t end) {
+#ifdef CPU_AVX2_KERNELS
+        if (useAvx2) {
+            skinRangeAvx2(input, paletteData, output, begin, end);
+            return;
+        }
+#endif
+        skinRange(input, paletteData, output, begin, end);
+    };
+
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    auto chunkCount = std::min(static_cast<size_t>(threadCount), input.vertexCount / MIN_VERTICES_PER_THREAD);
+
+    if (chunkCount <= 1) {
+        skinChunk(0, input.vertexCount);
+        return;
+    }
+
+    // Chunks are multiples of eight vertices, so only the last one runs the scalar tail
+    auto chunkSize = ((input.vertexCount + chunkCount - 1) / chunkCount + 7) & ~static_cast<size_t>(7);
+
+    std::vector<std::thread> threads;
+    for (size_t begin = chunkSize; begin < input.vertexCount; begin += chunkSize) {
+        threads.emplace_back(skinChunk, begin, std::min(begin + chunkSize, input.vertexCount));
+    }
+
+    // The calling thread takes the first chunk instead of idling
+    skinChunk(0, std::min(chunkSize, input.vertexCount));
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+std::vector<std::array<glm::vec3, 3>> CpuSkinning::getTriangles(const SkinningOutput& output, const std::vector<uint32_t>& indices, const glm::mat4& modelMatrix) {
+    std::vector<std::array<glm::vec3, 3>> triangles(indices.size() / 3);
+
+    for (size_t i = 0; i < triangles.size(); i++) {
+        for (size_t v = 0; v < 3; v++) {
+            auto index = indices[i * 3 + v];
+            auto position = glm::vec4(output.positions[0][index], output.positions[1][index], output.positions[2][index], 1.0f);
+            triangles[i][v] = glm::vec3(modelMatrix * position);
+        }
+    }
+    return triangles;
+}
+
+void CpuSkinning::writeVertices(const SkinningOutput& output, std::vector<Vertex>& vertices) {
+    if (vertices.size() != output.vertexCount) {
+        throw std::runtime_error("Skinned vertex count doesn't match the mesh.");
+    }
+
+    for (size_t i = 0; i < vertices.size(); i++) {
+        auto& vertex = vertices[i];
+
+        for (int c = 0; c < 3; c++) {
+            vertex.pos[c] = output.positions[c][i];
+            vertex.normal[c] = output.normals[c][i];
+            vertex.tangent[c] = output.tangents[c][i];
+        }
+    }
+}
+
+void CpuSkinning::skinRange(const SkinningInput& input, const float* palette, SkinningOutput& output, size_t begin, size_t end) {
+    auto matrices = reinterpret_cast<const glm::mat4*>(palette);
+
+    for (size_t i = begin; i < end; i++) {
+        glm::mat4 boneTransform(0.0f);
+        for (size_t b = 0; b < Vertex::BONES_PER_VERTEX; b++) {
+            boneTransform += matrices[input.boneIds[b][i]] * input.boneWeights[b][i];
+        }
+
+        auto position = boneTransform * glm::vec4(input.positions[0][i], input.positions[1][i], input.positions[2][i], 1.0f);
+        auto normal = glm::vec3(boneTransform * glm::vec4(input.normals[0][i], input.normals[1][i], input.normals[2][i], 0.0f));
+        auto tangent = glm::vec3(boneTransform * glm::vec4(input.tangents[0][i], input.tangents[1][i], input.tangents[2][i], 0.0f));
+
+        normal /= std::sqrt(std::max(glm::dot(normal, normal), 1e-20f));
+        tangent /= std::sqrt(std::max(glm::dot(tangent, tangent), 1e-20f));
+
+        for (int c = 0; c < 3; c++) {
+            output.positions[c][i] = position[c];
+            output.normals[c][i] = normal[c];
+            output.tangents[c][i] = tangent[c];
+        }
+    }
+}
+
+#ifdef CPU_AVX2_KERNELS
+CPU_AVX2_FUNCTION static inline __m256 multiplyAdd(__m256 a, __m256 b, __m256 c) {
+    return _mm256_fmadd_ps(a, b, c);
+}
+
+/** Transforms eight directions by the blended 3x3 part and normalizes them */
+CPU_AVX2_FUNCTION static inline void transformDirections(const __m256* m, const std::vector<float>* in, std::vector<float>* out, size_t i) {
+    auto x = _mm256_loadu_ps(in[0].data() + i);
+    auto y = _mm256_loadu_ps(in[1].data() + i);
+    auto z = _mm256_loadu_ps(in[2].data() + i);
+
+    __m256 result[3];
+    for (int r = 0; r < 3; r++) {
+        result[r] = multiplyAdd(m[r * 4 + 2], z, multiplyAdd(m[r * 4 + 1], y, _mm256_mul_ps(m[r * 4 + 0], x)));
+    }
+
+    auto lengthSquared = multiplyAdd(result[2], result[2], multiplyAdd(result[1], result[1], _mm256_mul_ps(result[0], result[0])));
+    auto length = _mm256_sqrt_ps(_mm256_max_ps(lengthSquared, _mm256_set1_ps(1e-20f)));
+
+    for (int r = 0; r < 3; r++) {
+        _mm256_storeu_ps(out[r].data() + i, _mm256_div_ps(result[r], length));
+    }
+}
+
+CPU_AVX2_FUNCTION void CpuSkinning::skinRangeAvx2(const SkinningInput& input, const float* palette, SkinningOutput& output, size_t begin, size_t end) {
+    size_t i = begin;
+
+    for (; i + 8 <= end; i += 8) {
+        // Upper 3x4 of the blended bone matrix for eight vertices, m[row * 4 + column]
+        __m256 m[12];
+        for (int k = 0; k < 12; k++) {
+            m[k] = _mm256_setzero_ps();
+        }
+
+        for (size_t b = 0; b < Vertex::BONES_PER_VERTEX; b++) {
+            auto weights = _mm256_loadu_ps(input.boneWeights[b].data() + i);
+
+            // Most vertices use fewer than four influences, skip the gathers when none of the eight does
+            if (_mm256_movemask_ps(_mm256_cmp_ps(weights, _mm256_setzero_ps(), _CMP_NEQ_OQ)) == 0) {
+                continue;
+            }
+
+            // glm matrices are column-major, element (row, column) of bone n is at n * 16 + column * 4 + row
+            auto base = _mm256_slli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input.boneIds[b].data() + i)), 4);
+
+            for (int column = 0; column < 4; column++) {
+                for (int row = 0; row < 3; row++) {
+                    auto offsets = _mm256_add_epi32(base, _mm256_set1_epi32(column * 4 + row));
+                    m[row * 4 + column] = multiplyAdd(weights, _mm256_i32gather_ps(palette, offsets, 4), m[row * 4 + column]);
+                }
+            }
+        }
+
+        auto x = _mm256_loadu_ps(input.positions[0].data() + i);
+        auto y = _mm256_loadu_ps(input.positions[1].data() + i);
+        auto z = _mm256_loadu_ps(input.positions[2].data() + i);
+
+        for (int r = 0; r < 3; r++) {
+            auto position = multiplyAdd(m[r * 4 + 2], z, multiplyAdd(m[r * 4 + 1], y, multiplyAdd(m[r * 4 + 0], x, m[r * 4 + 3])));
+            _mm256_storeu_ps(output.positions[r].data() + i, position);
+        }
+
+        transformDirections(m, input.normals, output.normals, i);
+        transformDirections(m, input.tangents, output.tangents, i);
+    }
+
+    skinRange(input, palette, output, i, end);
+}
+#endif
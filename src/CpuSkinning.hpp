@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Vertex.hpp"
+#include "CpuFeatures.hpp"
+
+/** Bind-pose vertex streams in structure-of-arrays layout, so the SIMD kernel can skin eight vertices per iteration */
+struct SkinningInput {
+    size_t vertexCount = 0;
+    uint32_t maxBoneId = 0; // Highest bone referenced with a non-zero weight, the palette must be larger than this
+
+    std::vector<float> positions[3];
+    std::vector<float> normals[3];
+    std::vector<float> tangents[3];
+    std::vector<int32_t> boneIds[Vertex::BONES_PER_VERTEX];
+    std::vector<float> boneWeights[Vertex::BONES_PER_VERTEX];
+};
+
+/** Skinned model-space streams, same layout as the input */
+struct SkinningOutput {
+    size_t vertexCount = 0;
+
+    std::vector<float> positions[3];
+    std::vector<float> normals[3];
+    std::vector<float> tangents[3];
+};
+
+/**
+ * CPU counterpart of skinning.vert, for code that needs deformed geometry without a GPU (raycasts, physics,
+ * headless tools). Uses an AVX2 kernel when the CPU supports it and splits large meshes across threads.
+ */
+class CpuSkinning {
+
+public:
+    static SkinningInput createInput(const std::vector<Vertex>& vertices);
+
+    /** Applies the palette (as built by AnimationState) to every vertex, threadCount 0 uses all hardware threads */
+    static void skin(const SkinningInput& input, const std::vector<glm::mat4>& palette, SkinningOutput& output, uint32_t threadCount = 0);
+
+    /** World space triangles of the skinned mesh, placed by the model matrix, for KdTree's triangle constructor */
+    static std::vector<std::array<glm::vec3, 3>> getTriangles(const SkinningOutput& output, const std::vector<uint32_t>& indices, const glm::mat4& modelMatrix);
+
+    /** Copies skinned positions, normals and tangents into vertices for uploading with Mesh::updateVertexBuffer */
+    static void writeVertices(const SkinningOutput& output, std::vector<Vertex>& vertices);
+
+private:
+    // Vertices per thread below which spawning another thread costs more than it saves
+    static const size_t MIN_VERTICES_PER_THREAD = 4096;
+
+    static void skinRange(const SkinningInput& input, const float* palette, SkinningOutput& output, size_t begin, size_t end);
+#ifdef CPU_AVX2_KERNELS
+    static void skinRangeAvx2(const SkinningInput& input, const float* palette, SkinningOutput& output, size_t begin, size_t end);
+#endif
+
+};
@@ -0,0 +1,116 @@
+#include "DescriptorAllocator.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+    /** Descriptors per set for each type, scaled by the pool's set count */
+    struct PoolRatio {
+        VkDescriptorType type;
+        float descriptorsPerSet;
+    };
+
+    const PoolRatio poolRatios[] = {
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1.0f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.0f},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f},
+    };
+}
+
+DescriptorAllocator::DescriptorAllocator(VkDevice device, uint32_t initialSetsPerPool)
+        : device(device), nextSetsPerPool(initialSetsPerPool) {
+}
+
+DescriptorAllocator::~DescriptorAllocator() {
+    if (currentPool != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(device, currentPool, nullptr);
+    }
+    for (auto& pool : usedPools) {
+        vkDestroyDescriptorPool(device, pool, nullptr);
+    }
+    for (auto& pool : freePools) {
+        vkDestroyDescriptorPool(device, pool, nullptr);
+    }
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout) {
+    VkDescriptorSet set;
+    if (currentPool != VK_NULL_HANDLE && tryAllocate(layout, set)) {
+        return set;
+    }
+
+    // The current pool is exhausted (or there is none yet), continue with a fresh one
+    if (currentPool != VK_NULL_HANDLE) {
+        usedPools.push_back(currentPool);
+    }
+    currentPool = grabPool();
+
+    if (!tryAllocate(layout, set)) {
+        throw std::runtime_error("failed to allocate descriptor sets!");
+    }
+    return set;
+}
+
+void DescriptorAllocator::reset() {
+    if (currentPool != VK_NULL_HANDLE) {
+        usedPools.push_back(currentPool);
+        currentPool = VK_NULL_HANDLE;
+    }
+
+    for (auto& pool : usedPools) {
+        vkResetDescriptorPool(device, pool, 0);
+        freePools.push_back(pool);
+    }
+    usedPools.clear();
+}
+
+VkDescriptorPool DescriptorAllocator::grabPool() {
+    if (!freePools.empty()) {
+        auto pool = freePools.back();
+        freePools.pop_back();
+        return pool;
+    }
+
+    auto pool = createPool(nextSetsPerPool);
+    nextSetsPerPool = std::min(nextSetsPerPool * 2, MAX_SETS_PER_POOL);
+    return pool;
+}
+
+VkDescriptorPool DescriptorAllocator::createPool(uint32_t maxSets) {
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    for (const auto& ratio : poolRatios) {
+        poolSizes.push_back({ratio.type, static_cast<uint32_t>(ratio.descriptorsPerSet * maxSets)});
+    }
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = maxSets;
+
+    VkDescriptorPool pool;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor pool!");
+    }
+    return pool;
+}
+
+bool DescriptorAllocator::tryAllocate(VkDescriptorSetLayout layout, VkDescriptorSet& set) {
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = currentPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    auto result = vkAllocateDescriptorSets(device, &allocInfo, &set);
+    if (result == VK_SUCCESS) {
+        return true;
+    }
+    // Vulkan 1.0 drivers without VK_KHR_maintenance1 may report any error for an exhausted pool
+    if (result == VK_ERROR_OUT_OF_HOST_MEMORY || result == VK_ERROR_OUT_OF_DEVICE_MEMORY) {
+        throw std::runtime_error("failed to allocate descriptor sets!");
+    }
+    return false;
+}
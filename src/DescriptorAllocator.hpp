@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+/**
+ * Allocates descriptor sets from a chain of shared pools. When a pool runs out, the next one is taken from the pools
+ * freed by the last reset() or created with twice the capacity of the previous one. Sets can't be freed individually,
+ * reset() releases all of them at once, so an allocator should only hold sets with the same lifetime (e.g. those of a
+ * swap chain or of a single frame).
+ */
+class DescriptorAllocator {
+
+public:
+    explicit DescriptorAllocator(VkDevice device, uint32_t initialSetsPerPool = DEFAULT_SETS_PER_POOL);
+    virtual ~DescriptorAllocator();
+
+    VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+
+    /** Returns all sets to their pools, none of them may still be in use by the GPU */
+    void reset();
+
+    size_t getPoolCount() const { return usedPools.size() + freePools.size(); }
+
+    static const uint32_t DEFAULT_SETS_PER_POOL = 64;
+    static const uint32_t MAX_SETS_PER_POOL = 4096;
+
+private:
+    VkDevice device;
+    uint32_t nextSetsPerPool;
+
+    VkDescriptorPool currentPool = VK_NULL_HANDLE;
+    std::vector<VkDescriptorPool> usedPools; // Full pools, not including the current one
+    std::vector<VkDescriptorPool> freePools; // Reset pools, ready for reuse
+
+    VkDescriptorPool grabPool();
+    VkDescriptorPool createPool(uint32_t maxSets);
+    bool tryAllocate(VkDescriptorSetLayout layout, VkDescriptorSet& set);
+
+};
@@ -0,0 +1,45 @@
+#include "DescriptorLayoutCache.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+DescriptorLayoutCache::DescriptorLayoutCache(VkDevice device) : device(device) {
+}
+
+DescriptorLayoutCache::~DescriptorLayoutCache() {
+    for (auto& entry : layouts) {
+        vkDestroyDescriptorSetLayout(device, entry.second, nullptr);
+    }
+}
+
+VkDescriptorSetLayout DescriptorLayoutCache::getLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings) {
+    std::vector<BindingKey> key;
+    key.reserve(bindings.size());
+    for (const auto& binding : bindings) {
+        if (binding.pImmutableSamplers != nullptr) {
+            throw std::runtime_error("Descriptor layouts with immutable samplers can't be cached.");
+        }
+        key.emplace_back(binding.binding, binding.descriptorType, binding.descriptorCount, binding.stageFlags);
+    }
+    std::sort(key.begin(), key.end());
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = layouts.find(key);
+    if (it != layouts.end()) {
+        return it->second;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    VkDescriptorSetLayout layout;
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor set layout!");
+    }
+
+    layouts[key] = layout;
+    return layout;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+/**
+ * Creates descriptor set layouts and hands out the same layout for identical binding lists, so objects with the same
+ * resources share a layout. The layouts live as long as the cache.
+ */
+class DescriptorLayoutCache {
+
+public:
+    explicit DescriptorLayoutCache(VkDevice device);
+    virtual ~DescriptorLayoutCache();
+
+    /** Bindings without immutable samplers only, the order of the bindings doesn't matter */
+    VkDescriptorSetLayout getLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+
+    size_t getLayoutCount() const { return layouts.size(); }
+
+private:
+    // binding, type, count, stages
+    using BindingKey = std::tuple<uint32_t, VkDescriptorType, uint32_t, VkShaderStageFlags>;
+
+    VkDevice device;
+    std::map<std::vector<BindingKey>, VkDescriptorSetLayout> layouts;
+    std::mutex mutex;
+
+};
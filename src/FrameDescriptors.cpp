@@ -0,0 +1,42 @@
+#include "FrameDescriptors.hpp"
+
+#include "DescriptorLayoutCache.hpp"
+
+FrameDescriptors::FrameDescriptors(VulkanDevice& device) : device(device) {
+    VkDescriptorSetLayoutBinding globalsBinding = {};
+    globalsBinding.binding = 0;
+    globalsBinding.descriptorCount = 1;
+    globalsBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    globalsBinding.pImmutableSamplers = nullptr;
+    globalsBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    descriptorSetLayout = device.descriptorLayoutCache->getLayout({globalsBinding});
+}
+
+void FrameDescriptors::initializeDescriptors(DescriptorAllocator& allocator, UniformRing& uniformRing) {
+    descriptorSet = allocator.allocate(descriptorSetLayout);
+
+    VkDescriptorBufferInfo globalsInfo = {};
+    globalsInfo.buffer = uniformRing.getBuffer();
+    globalsInfo.offset = 0;
+    globalsInfo.range = sizeof(Globals);
+
+    VkWriteDescriptorSet descriptorWrite = {};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = descriptorSet;
+    descriptorWrite.dstBinding = 0;
+    descriptorWrite.dstArrayElement = 0;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pBufferInfo = &globalsInfo;
+
+    vkUpdateDescriptorSets(device.device, 1, &descriptorWrite, 0, nullptr);
+}
+
+void FrameDescriptors::update(UniformRing& uniformRing, const Globals& globals) {
+    globalsOffset = uniformRing.push(globals);
+}
+
+void FrameDescriptors::bind(VkCommandBuffer commandBuffer, Pipeline& pipeline) {
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getLayout(), SET_INDEX, 1, &descriptorSet, 1, &globalsOffset);
+}
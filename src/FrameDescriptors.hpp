@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include "VulkanDevice.hpp"
+#include "UniformRing.hpp"
+#include "DescriptorAllocator.hpp"
+#include "Pipeline.hpp"
+#include "Globals.hpp"
+
+/**
+ * Descriptor set 0 of every pipeline, holding the data shared by all objects of a frame. It is written into the uniform
+ * ring once per frame, so its cost doesn't depend on the number of objects. Per-object data is in set 1, see Uniforms.
+ */
+class FrameDescriptors {
+
+public:
+    explicit FrameDescriptors(VulkanDevice& device);
+    virtual ~FrameDescriptors() = default;
+
+    /** The set is released by resetting the allocator, the globals point into the ring, which has to outlive it */
+    void initializeDescriptors(DescriptorAllocator& allocator, UniformRing& uniformRing);
+
+    void update(UniformRing& uniformRing, const Globals& globals);
+    void bind(VkCommandBuffer commandBuffer, Pipeline& pipeline);
+
+    VkDescriptorSetLayout getDescriptorSetLayout() { return descriptorSetLayout; }
+
+    static const uint32_t SET_INDEX = 0;
+
+private:
+    VulkanDevice& device;
+
+    VkDescriptorSetLayout descriptorSetLayout; // Owned by the device's layout cache
+    VkDescriptorSet descriptorSet;
+    uint32_t globalsOffset = 0;
+
+};
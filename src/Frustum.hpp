@@ -0,0 +1,54 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+/** Axis-aligned bounding box */
+struct BoundingBox {
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+/** View frustum as six inward facing, normalized planes in the space the source matrix transforms from */
+struct Frustum {
+    glm::vec4 planes[6];
+
+    /** Extracts the planes of a projection (times view and model) matrix with a 0 to 1 depth range */
+    static Frustum fromMatrix(const glm::mat4& m) {
+        auto row = [&m](int i) {
+            return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+        };
+
+        Frustum frustum;
+        frustum.planes[0] = row(3) + row(0); // Left
+        frustum.planes[1] = row(3) - row(0); // Right
+        frustum.planes[2] = row(3) + row(1); // Bottom
+        frustum.planes[3] = row(3) - row(1); // Top
+        frustum.planes[4] = row(2); // Near
+        frustum.planes[5] = row(3) - row(2); // Far
+
+        for (auto& plane : frustum.planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+        return frustum;
+    }
+
+    bool intersectsSphere(glm::vec3 center, float radius) const {
+        for (const auto& plane : planes) {
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** Box given by its center and half extents along the axes */
+    bool intersectsBox(glm::vec3 center, glm::vec3 extent) const {
+        for (const auto& plane : planes) {
+            auto normal = glm::vec3(plane);
+            if (glm::dot(normal, center) + plane.w < -glm::dot(glm::abs(normal), extent)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
@@ -0,0 +1,105 @@
+#include "FrustumCulling.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+#ifdef CPU_AVX2_KERNELS
+#include <immintrin.h>
+#endif
+
+void CullingBoxes::add(glm::vec3 center, glm::vec3 extent) {
+    centerX.push_back(center.x);
+    centerY.push_back(center.y);
+    centerZ.push_back(center.z);
+    extentX.push_back(extent.x);
+    extentY.push_back(extent.y);
+    extentZ.push_back(extent.z);
+}
+
+void CullingBoxes::clear() {
+    centerX.clear();
+    centerY.clear();
+    centerZ.clear();
+    extentX.clear();
+    extentY.clear();
+    extentZ.clear();
+}
+
+void FrustumCulling::transformBox(const BoundingBox& box, const glm::mat4& matrix, glm::vec3& center, glm::vec3& extent, float margin) {
+    auto localCenter = (box.min + box.max) * 0.5f;
+    auto localExtent = (box.max - box.min) * 0.5f;
+    localExtent += glm::vec3(margin * std::max(localExtent.x, std::max(localExtent.y, localExtent.z)));
+
+    // Each world axis gathers the extents along all local axes it's rotated or scaled from (Arvo's method)
+    center = glm::vec3(matrix * glm::vec4(localCenter, 1.0f));
+    extent = glm::abs(glm::vec3(matrix[0])) * localExtent.x
+        + glm::abs(glm::vec3(matrix[1])) * localExtent.y
+        + glm::abs(glm::vec3(matrix[2])) * localExtent.z;
+}
+
+void FrustumCulling::cullBoxes(const Frustum& frustum, const CullingBoxes& boxes, std::vector<uint8_t>& visible) {
+    auto count = boxes.size();
+    visible.resize(count);
+    size_t i = 0;
+
+#ifdef CPU_AVX2_KERNELS
+    if (CpuFeatures::hasAvx2()) {
+        i = cullBoxesAvx2(frustum, boxes, visible);
+    }
+#endif
+
+    for (; i < count; i++) {
+        auto center = glm::vec3(boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i]);
+        auto extent = glm::vec3(boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i]);
+        visible[i] = frustum.intersectsBox(center, extent) ? 1 : 0;
+    }
+}
+
+#ifdef CPU_AVX2_KERNELS
+CPU_AVX2_FUNCTION static inline __m256 multiplyAdd(__m256 a, __m256 b, __m256 c) {
+    return _mm256_fmadd_ps(a, b, c);
+}
+
+CPU_AVX2_FUNCTION size_t FrustumCulling::cullBoxesAvx2(const Frustum& frustum, const CullingBoxes& boxes, std::vector<uint8_t>& visible) {
+    auto count = boxes.size();
+    size_t i = 0;
+
+    __m256 normalX[6], normalY[6], normalZ[6], distance[6];
+    __m256 absNormalX[6], absNormalY[6], absNormalZ[6];
+    for (int p = 0; p < 6; p++) {
+        const auto& plane = frustum.planes[p];
+        normalX[p] = _mm256_set1_ps(plane.x);
+        normalY[p] = _mm256_set1_ps(plane.y);
+        normalZ[p] = _mm256_set1_ps(plane.z);
+        distance[p] = _mm256_set1_ps(plane.w);
+        absNormalX[p] = _mm256_set1_ps(std::abs(plane.x));
+        absNormalY[p] = _mm256_set1_ps(std::abs(plane.y));
+        absNormalZ[p] = _mm256_set1_ps(std::abs(plane.z));
+    }
+    auto zero = _mm256_setzero_ps();
+
+    for (; i + 8 <= count; i += 8) {
+        auto centerX = _mm256_loadu_ps(boxes.centerX.data() + i);
+        auto centerY = _mm256_loadu_ps(boxes.centerY.data() + i);
+        auto centerZ = _mm256_loadu_ps(boxes.centerZ.data() + i);
+        auto extentX = _mm256_loadu_ps(boxes.extentX.data() + i);
+        auto extentY = _mm256_loadu_ps(boxes.extentY.data() + i);
+        auto extentZ = _mm256_loadu_ps(boxes.extentZ.data() + i);
+
+        // A box is outside if its center lies further behind any plane than the box's projected radius
+        auto inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            auto centerDistance = multiplyAdd(normalX[p], centerX, multiplyAdd(normalY[p], centerY, multiplyAdd(normalZ[p], centerZ, distance[p])));
+            auto radius = multiplyAdd(absNormalX[p], extentX, multiplyAdd(absNormalY[p], extentY, _mm256_mul_ps(absNormalZ[p], extentZ)));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(centerDistance, radius), zero, _CMP_GE_OQ));
+        }
+
+        auto mask = _mm256_movemask_ps(inside);
+        for (int k = 0; k < 8; k++) {
+            visible[i + k] = static_cast<uint8_t>((mask >> k) & 1);
+        }
+    }
+
+    return i;
+}
+#endif
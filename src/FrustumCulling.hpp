@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Frustum.hpp"
+#include "CpuFeatures.hpp"
+
+/** Boxes as centers and half extents in structure-of-arrays layout, so several can be tested at once */
+struct CullingBoxes {
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+
+    void add(glm::vec3 center, glm::vec3 extent);
+    void clear();
+    size_t size() const { return centerX.size(); }
+};
+
+/** Per-frame mesh culling counters, reset at the start of every frame */
+struct CullingStats {
+    uint32_t testedMeshes;
+    uint32_t visibleMeshes; // Of the tested ones
+    uint32_t untestedMeshes; // Drawn without a test because culling is disabled for them
+};
+
+class FrustumCulling {
+
+public:
+    /**
+     * Bounds of the box after transforming it with the matrix, as center and half extents. A margin grows each local
+     * half extent by that fraction of the largest one first.
+     */
+    static void transformBox(const BoundingBox& box, const glm::mat4& matrix, glm::vec3& center, glm::vec3& extent, float margin = 0.0f);
+
+    // Margin for the bind-pose bounds of skinned meshes, enough for limbs animated away from the body
+    static constexpr float SKINNED_BOUNDS_MARGIN = 0.5f;
+
+    /** Sets visible[i] to 1 if box i intersects the frustum and to 0 otherwise, testing eight boxes at a time with AVX2 where supported */
+    static void cullBoxes(const Frustum& frustum, const CullingBoxes& boxes, std::vector<uint8_t>& visible);
+
+private:
+#ifdef CPU_AVX2_KERNELS
+    /** Tests boxes from the first one up to a multiple of eight, returns the index the scalar loop continues at */
+    static size_t cullBoxesAvx2(const Frustum& frustum, const CullingBoxes& boxes, std::vector<uint8_t>& visible);
+#endif
+
+};
@@ -0,0 +1,159 @@
+#include "GeometryArena.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "VulkanUtils.hpp"
+#include "UploadQueue.hpp"
+#include "StagingRing.hpp"
+
+GeometryArena::GeometryArena(VulkanDevice& device, VertexFormat format)
+        : device(device), format(format), vertexStride(Vertex::getBindingDescription(format).stride),
+          boneStride(Vertex::getBoneStreamStride(format)), vertexAllocator(INITIAL_VERTEX_CAPACITY), indexAllocator(INITIAL_INDEX_CAPACITY) {
+    createBuffers(INITIAL_VERTEX_CAPACITY, INITIAL_INDEX_CAPACITY);
+}
+
+GeometryArena::~GeometryArena() {
+    device.freeBuffer(vertexBuffer);
+    device.freeBuffer(positionBuffer);
+    device.freeBuffer(boneBuffer);
+    device.freeBuffer(indexBuffer);
+}
+
+void GeometryArena::createBuffers(uint64_t vertexCapacity, uint64_t indexCapacity) {
+    auto usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    device.createBuffer(vertexCapacity * vertexStride, usage | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, MemoryCategory::Mesh);
+    device.createBuffer(vertexCapacity * sizeof(glm::vec3), usage | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, positionBuffer, MemoryCategory::Mesh);
+    device.createBuffer(vertexCapacity * boneStride, usage | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, boneBuffer, MemoryCategory::Mesh);
+    device.createBuffer(indexCapacity, usage | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, MemoryCategory::Mesh);
+}
+
+GeometryAllocation GeometryArena::allocate(uint32_t vertexCount, uint32_t indexCount, VkIndexType indexType) {
+    GeometryAllocation allocation = {};
+    allocation.vertexCount = vertexCount;
+    allocation.indexCount = indexCount;
+    allocation.indexType = indexType;
+
+    if (vertexCount > 0) {
+        auto offset = vertexAllocator.allocate(vertexCount);
+        if (offset == RangeAllocator::INVALID_OFFSET) {
+            growVertices(vertexAllocator.getCapacity() + vertexCount);
+            offset = vertexAllocator.allocate(vertexCount);
+        }
+        allocation.firstVertex = static_cast<uint32_t>(offset);
+    }
+
+    if (indexCount > 0) {
+        auto indexSize = getIndexSize(indexType);
+        auto offset = indexAllocator.allocate(indexCount * indexSize, indexSize);
+        if (offset == RangeAllocator::INVALID_OFFSET) {
+            growIndices(indexAllocator.getCapacity() + indexCount * indexSize);
+            offset = indexAllocator.allocate(indexCount * indexSize, indexSize);
+        }
+        allocation.firstIndex = static_cast<uint32_t>(offset / indexSize);
+    }
+
+    return allocation;
+}
+
+void GeometryArena::free(const GeometryAllocation& allocation) {
+    if (allocation.vertexCount > 0) {
+        vertexAllocator.free(allocation.firstVertex, allocation.vertexCount);
+    }
+    if (allocation.indexCount > 0) {
+        auto indexSize = getIndexSize(allocation.indexType);
+        indexAllocator.free(static_cast<uint64_t>(allocation.firstIndex) * indexSize, allocation.indexCount * indexSize);
+    }
+}
+
+void GeometryArena::upload(const GeometryAllocation& allocation, GeometryStream stream, const void* data, VkDeviceSize size, uint32_t firstElement) {
+    if (size == 0) {
+        return;
+    }
+
+    VulkanBuffer* target = nullptr;
+    VkDeviceSize offset = 0;
+    switch (stream) {
+        case GeometryStream::Vertex:
+            target = &vertexBuffer;
+            offset = static_cast<VkDeviceSize>(allocation.firstVertex + firstElement) * vertexStride;
+            break;
+        case GeometryStream::Position:
+            target = &positionBuffer;
+            offset = static_cast<VkDeviceSize>(allocation.firstVertex + firstElement) * sizeof(glm::vec3);
+            break;
+        case GeometryStream::Bone:
+            target = &boneBuffer;
+            offset = static_cast<VkDeviceSize>(allocation.firstVertex + firstElement) * boneStride;
+            break;
+        case GeometryStream::Index:
+            target = &indexBuffer;
+            offset = static_cast<VkDeviceSize>(allocation.firstIndex + firstElement) * getIndexSize(allocation.indexType);
+            break;
+    }
+
+    auto staging = device.stagingRing->allocate(size);
+    memcpy(staging.mapped, data, (size_t) size);
+
+    // Frames in flight may still draw the range, either a mesh updating its vertices or one freed before it was reused
+    device.uploadQueue->waitForVertexInput();
+
+    VulkanUtils::copyBuffer(device, staging.buffer, target->buffer, size, staging.offset, offset);
+}
+
+void GeometryArena::bindBuffers(VkCommandBuffer commandBuffer, VkIndexType indexType) {
+    VkBuffer vertexBuffers[] = {vertexBuffer.buffer};
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+
+    vkCmdBindIndexBuffer(commandBuffer, indexBuffer.buffer, 0, indexType);
+}
+
+void GeometryArena::bindDepthBuffers(VkCommandBuffer commandBuffer, VkIndexType indexType) {
+    // The bone stream covers every vertex slot, so binding it for static meshes too is harmless
+    VkBuffer vertexBuffers[] = {positionBuffer.buffer, boneBuffer.buffer};
+    VkDeviceSize offsets[] = {0, 0};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
+
+    vkCmdBindIndexBuffer(commandBuffer, indexBuffer.buffer, 0, indexType);
+}
+
+VkDeviceSize GeometryArena::getAllocatedSize() const {
+    return vertexAllocator.getUsedSize() * (vertexStride + sizeof(glm::vec3) + boneStride) + indexAllocator.getUsedSize();
+}
+
+VkDeviceSize GeometryArena::getCapacitySize() const {
+    return vertexAllocator.getCapacity() * (vertexStride + sizeof(glm::vec3) + boneStride) + indexAllocator.getCapacity();
+}
+
+void GeometryArena::growVertices(uint64_t minimumCapacity) {
+    auto oldCapacity = vertexAllocator.getCapacity();
+    auto newCapacity = std::max(oldCapacity * 2, minimumCapacity);
+
+    auto usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    replaceBuffer(vertexBuffer, oldCapacity * vertexStride, newCapacity * vertexStride, usage);
+    replaceBuffer(positionBuffer, oldCapacity * sizeof(glm::vec3), newCapacity * sizeof(glm::vec3), usage);
+    replaceBuffer(boneBuffer, oldCapacity * boneStride, newCapacity * boneStride, usage);
+    vertexAllocator.grow(newCapacity);
+}
+
+void GeometryArena::growIndices(uint64_t minimumCapacity) {
+    auto oldCapacity = indexAllocator.getCapacity();
+    auto newCapacity = std::max(oldCapacity * 2, minimumCapacity);
+
+    auto usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    replaceBuffer(indexBuffer, oldCapacity, newCapacity, usage);
+    indexAllocator.grow(newCapacity);
+}
+
+void GeometryArena::replaceBuffer(VulkanBuffer& buffer, VkDeviceSize oldSize, VkDeviceSize newSize, VkBufferUsageFlags usage) {
+    VulkanBuffer newBuffer;
+    device.createBuffer(newSize, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, newBuffer, MemoryCategory::Mesh);
+    VulkanUtils::copyBuffer(device, buffer.buffer, newBuffer.buffer, oldSize);
+    device.uploadQueue->flush();
+
+    // Command buffers of frames in flight may still reference the old buffer
+    vkDeviceWaitIdle(device.device);
+    device.freeBuffer(buffer);
+    buffer = newBuffer;
+}
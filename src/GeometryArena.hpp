@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include "VulkanDevice.hpp"
+#include "VulkanBuffer.hpp"
+#include "Vertex.hpp"
+#include "RangeAllocator.hpp"
+
+/** A mesh's share of a GeometryArena, vertices are counted in elements and indices in the allocation's index type */
+struct GeometryAllocation {
+    uint32_t firstVertex;
+    uint32_t vertexCount;
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    VkIndexType indexType;
+};
+
+enum class GeometryStream {
+    Vertex, // Interleaved attributes in the arena's vertex format
+    Position, // vec3 positions for depth passes
+    Bone, // Bone ids and weights for skinned depth passes
+    Index
+};
+
+/**
+ * Device-local vertex and index buffers shared by all meshes of one vertex format. Every vertex stream is indexed by
+ * the same vertex slot, so a mesh draws with its firstVertex as vertexOffset and all meshes use the same bindings.
+ * The buffers grow (keeping every allocation's offset) when they run out of space.
+ */
+class GeometryArena {
+
+public:
+    GeometryArena(VulkanDevice& device, VertexFormat format);
+    virtual ~GeometryArena();
+
+    GeometryAllocation allocate(uint32_t vertexCount, uint32_t indexCount, VkIndexType indexType);
+    void free(const GeometryAllocation& allocation);
+
+    /** Copies data for the allocation's vertices or indices into one of the streams, starting firstElement into the allocation */
+    void upload(const GeometryAllocation& allocation, GeometryStream stream, const void* data, VkDeviceSize size, uint32_t firstElement = 0);
+
+    void bindBuffers(VkCommandBuffer commandBuffer, VkIndexType indexType);
+
+    /** Binds the position (binding 0) and bone stream (binding 1) for depth-only passes */
+    void bindDepthBuffers(VkCommandBuffer commandBuffer, VkIndexType indexType);
+
+    VertexFormat getFormat() const { return format; }
+    VkDeviceSize getAllocatedSize() const;
+    VkDeviceSize getCapacitySize() const;
+
+    static uint32_t getIndexSize(VkIndexType indexType) { return indexType == VK_INDEX_TYPE_UINT16 ? 2 : 4; }
+
+private:
+    VulkanDevice& device;
+    VertexFormat format;
+    uint32_t vertexStride;
+    uint32_t boneStride;
+
+    RangeAllocator vertexAllocator; // In vertices
+    RangeAllocator indexAllocator; // In bytes
+
+    VulkanBuffer vertexBuffer;
+    VulkanBuffer positionBuffer;
+    VulkanBuffer boneBuffer;
+    VulkanBuffer indexBuffer;
+
+    static const uint32_t INITIAL_VERTEX_CAPACITY = 1 << 16;
+    static const VkDeviceSize INITIAL_INDEX_CAPACITY = 1 << 20;
+
+    void createBuffers(uint64_t vertexCapacity, uint64_t indexCapacity);
+    void growVertices(uint64_t minimumCapacity);
+    void growIndices(uint64_t minimumCapacity);
+    void replaceBuffer(VulkanBuffer& buffer, VkDeviceSize oldSize, VkDeviceSize newSize, VkBufferUsageFlags usage);
+
+};
@@ -4,12 +4,10 @@
 
 const int MAX_BONES = 64;
 
+/** Per-object data, passed as push constants */
 struct LocalTransform {
     alignas(16) glm::mat4 model;
-    alignas(16) glm::mat4 view;
-    alignas(16) glm::mat4 proj;
-    alignas(16) glm::mat4 lightSpace;
-    alignas(16) glm::mat4 boneTransforms[MAX_BONES];
+    uint32_t materialIndex; // Into the bindless material table, only read by bindless shaders
 };
 
 struct LocalTransformShadow {
@@ -17,6 +15,9 @@ struct LocalTransformShadow {
 };
 
 struct Globals {
+    alignas(16) glm::mat4 view;
+    alignas(16) glm::mat4 proj;
+    alignas(16) glm::mat4 lightSpace;
     alignas(16) glm::vec3 viewPos;
     alignas(16) glm::vec3 ambientColor;
     alignas(16) Light lights[MAX_LIGHTS];
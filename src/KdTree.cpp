@@ -36,6 +36,18 @@ KdTree::KdTree(std::vector<std::shared_ptr<Model>> models)
   buildSubtree(root, triDataList, MAX_DEPTH);
 }
 
+KdTree::KdTree(const std::vector<KdTreeTriangle>& triangles)
+{
+  std::vector<KdTreeTriangleBuildData> triDataList(triangles.size());
+  for (size_t i = 0; i < triangles.size(); i++) {
+    triDataList[i].triangle = triangles[i];
+    triDataList[i].bounds = getBoundingBox(triangles[i]);
+  }
+
+  root = new KdTreeNode();
+  buildSubtree(root, triDataList, MAX_DEPTH);
+}
+
 KdTreeRaycastHit KdTree::raycast(glm::vec3 originPoint, glm::vec3 direction, float maxDistance) {
 
   KdTreeRaycastHit hit = {};
@@ -339,8 +351,7 @@ std::shared_ptr<Model> KdTree::createLineModelForBoundingBoxes(
 
   std::cout << " created bounding box visualization. " << std::endl;
 
-  std::unordered_map<std::string, Animation> emptyAnimations;
-  return std::make_shared<Model>(meshes, emptyAnimations, pipelineSettings, uniforms, nullptr, device);
+  return std::make_shared<Model>(meshes, nullptr, pipelineSettings, uniforms, nullptr, device);
 
 }
 
@@ -352,11 +363,12 @@ std::shared_ptr<Model> KdTree::createHitTriangleModel(
   std::vector<Vertex> vertices = { Vertex(), Vertex(), Vertex() };
   std::vector<uint32_t> indices = { 0, 1, 2 };
 
+  // Rewritten after every raycast
   std::unordered_map<std::string, MeshBoneData> emptyBoneData;
   std::vector<std::shared_ptr<Mesh>> meshes;
-  meshes.push_back(std::make_shared<Mesh>(device, vertices, indices, emptyBoneData));
+  meshes.push_back(std::make_shared<Mesh>(device, vertices, indices, emptyBoneData, pipelineSettings->vertexFormat,
+                                          std::vector<MeshLod>(), std::vector<Meshlet>(), MeshUsage::Dynamic));
 
-  std::unordered_map<std::string, Animation> emptyAnimations;
-  return std::make_shared<Model>(meshes, emptyAnimations, pipelineSettings, uniforms, nullptr, device);
+  return std::make_shared<Model>(meshes, nullptr, pipelineSettings, uniforms, nullptr, device);
 }
 
@@ -56,6 +56,9 @@ class KdTree {
     
 public:
   KdTree(std::vector<std::shared_ptr<Model>> models);
+  // For geometry that doesn't come from a static mesh, e.g. CpuSkinning::getTriangles. Unlike the models, the triangles
+  // aren't transformed, they have to be in world space already.
+  KdTree(const std::vector<KdTreeTriangle>& triangles);
 
   std::shared_ptr<Model> createLineModelForBoundingBoxes(
     VulkanDevice& device,
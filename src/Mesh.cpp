@@ -2,81 +2,320 @@
 
 #include "VulkanUtils.hpp"
 
-Mesh::Mesh(VulkanDevice& device, std::vector<Vertex> vertices, std::vector<uint32_t> indices, std::unordered_map<std::string, MeshBoneData> boneData)
-        : device(device), vertices(vertices), indices(indices), boneData(boneData) {
-            
-    boneTransforms.resize(boneData.size(), glm::mat4(1.0f));
-    createVertexBuffer();
-    createIndexBuffer();
+#include <limits>
+#include <algorithm>
+
+Mesh::Mesh(VulkanDevice& device, std::vector<Vertex> vertices, std::vector<uint32_t> indices, std::unordered_map<std::string, MeshBoneData> boneData,
+           VertexFormat format, std::vector<MeshLod> lods, std::vector<Meshlet> meshlets, MeshUsage usage)
+        : device(device), vertices(vertices), indices(indices), lods(lods), meshlets(meshlets), boneData(boneData), format(format),
+          usage(usage), boneStream(!boneData.empty()), indexType(VK_INDEX_TYPE_UINT32), arena(device.getGeometryArena(format)) {
+    
+    calculateBounds();
+    
+    auto indexData = createIndexData();
+    auto indexCount = static_cast<uint32_t>(indexData.size() / GeometryArena::getIndexSize(indexType));
+    
+    // Dynamic meshes only keep their indices in the arena
+    auto arenaVertexCount = usage == MeshUsage::Static ? static_cast<uint32_t>(vertices.size()) : 0;
+    allocation = arena.allocate(arenaVertexCount, indexCount, indexType);
+    
+    if (usage == MeshUsage::Static) {
+        createVertexBuffer();
+    } else {
+        createDynamicBuffers();
+    }
+    arena.upload(allocation, GeometryStream::Index, indexData.data(), indexData.size());
 }
 
 Mesh::~Mesh() {
-    device.freeBuffer(indexBuffer);
-    device.freeBuffer(vertexBuffer);
+    arena.free(allocation);
+    
+    if (usage == MeshUsage::Dynamic) {
+        device.freeBuffer(dynamicVertexBuffer);
+        device.freeBuffer(dynamicPositionBuffer);
+        device.freeBuffer(dynamicBoneBuffer);
+    }
+}
+
+std::vector<uint8_t> Mesh::getVertexData() {
+    std::vector<uint8_t> data(Vertex::getBindingDescription(format).stride * vertices.size());
+    encodeVertices(0, vertices.size(), data.data());
+    return data;
+}
+
+void Mesh::encodeVertices(size_t firstVertex, size_t vertexCount, uint8_t* target) {
+    if (format == VertexFormat::Packed) {
+        auto packedVertices = reinterpret_cast<PackedVertex*>(target);
+        for (size_t i = 0; i < vertexCount; i++) {
+            packedVertices[i] = PackedVertex::fromVertex(vertices[firstVertex + i]);
+        }
+        return;
+    }
+    
+    memcpy(target, vertices.data() + firstVertex, sizeof(Vertex) * vertexCount);
+}
+
+std::vector<glm::vec3> Mesh::getPositionData() {
+    std::vector<glm::vec3> positions(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        positions[i] = vertices[i].pos;
+    }
+    return positions;
+}
+
+std::vector<uint8_t> Mesh::getBoneStreamData() {
+    auto stride = Vertex::getBoneStreamStride(format);
+    std::vector<uint8_t> data(stride * vertices.size());
+    
+    for (size_t i = 0; i < vertices.size(); i++) {
+        auto target = data.data() + i * stride;
+        
+        if (format == VertexFormat::Packed) {
+            auto packed = PackedVertex::fromVertex(vertices[i]);
+            memcpy(target, packed.boneIds, sizeof(packed.boneIds));
+            memcpy(target + sizeof(packed.boneIds), packed.boneWeights, sizeof(packed.boneWeights));
+        } else {
+            memcpy(target, vertices[i].boneIds, sizeof(vertices[i].boneIds));
+            memcpy(target + sizeof(vertices[i].boneIds), vertices[i].boneWeights, sizeof(vertices[i].boneWeights));
+        }
+    }
+    return data;
 }
 
 void Mesh::createVertexBuffer() {
-    VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
+    auto vertexData = getVertexData();
+    arena.upload(allocation, GeometryStream::Vertex, vertexData.data(), vertexData.size());
     
-    VulkanBuffer stagingBuffer;
-    device.createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer);
+    auto positionData = getPositionData();
+    arena.upload(allocation, GeometryStream::Position, positionData.data(), sizeof(positionData[0]) * positionData.size());
     
-    void* data;
-    vkMapMemory(device.device, stagingBuffer.memory, 0, bufferSize, 0, &data);
-    memcpy(data, vertices.data(), (size_t) bufferSize);
-    vkUnmapMemory(device.device, stagingBuffer.memory);
+    if (hasBoneStream()) {
+        auto boneStreamData = getBoneStreamData();
+        arena.upload(allocation, GeometryStream::Bone, boneStreamData.data(), boneStreamData.size());
+    }
+}
+
+void Mesh::createDynamicBuffers() {
+    auto stride = Vertex::getBindingDescription(format).stride;
+    auto hostMemory = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
     
-    device.createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer);
+    device.createBuffer(stride * vertices.size() * DYNAMIC_BUFFER_COUNT, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, hostMemory, dynamicVertexBuffer, MemoryCategory::Mesh);
+    device.createBuffer(sizeof(glm::vec3) * vertices.size() * DYNAMIC_BUFFER_COUNT, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, hostMemory, dynamicPositionBuffer, MemoryCategory::Mesh);
     
-    VulkanUtils::copyBuffer(device, stagingBuffer.buffer, vertexBuffer.buffer, bufferSize);
+    // Host-visible memory stays mapped for the buffers' lifetime, updates are plain writes
+    dynamicVertexData = static_cast<uint8_t*>(dynamicVertexBuffer.allocation.mapped);
+    dynamicPositionData = static_cast<glm::vec3*>(dynamicPositionBuffer.allocation.mapped);
     
-    device.freeBuffer(stagingBuffer);
+    // Bone ids and weights never change, a single copy serves every slot
+    auto boneStreamData = getBoneStreamData();
+    device.createBuffer(std::max<VkDeviceSize>(boneStreamData.size(), 1), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, hostMemory, dynamicBoneBuffer, MemoryCategory::Mesh);
+    if (!boneStreamData.empty()) {
+        memcpy(dynamicBoneBuffer.allocation.mapped, boneStreamData.data(), boneStreamData.size());
+    }
+    
+    for (uint32_t slot = 0; slot < DYNAMIC_BUFFER_COUNT; slot++) {
+        dirtyRanges[slot] = { 0, vertices.size() };
+    }
+    dynamicSlot = DYNAMIC_BUFFER_COUNT - 1;
+    updateVertexBuffer();
 }
 
 void Mesh::updateVertexBuffer() {
-    VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
+    // All vertices may have moved, so the bounds can shrink too
+    calculateBounds();
+    updateVertexBuffer(0, vertices.size());
+}
+
+void Mesh::updateVertexBuffer(size_t firstVertex, size_t vertexCount) {
+    growBounds(firstVertex, vertexCount);
     
-    VulkanBuffer stagingBuffer;
-    device.createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer);
+    // Bone ids and weights don't change after loading, only the interleaved and position streams are refreshed
+    if (usage == MeshUsage::Static) {
+        std::vector<uint8_t> vertexData(Vertex::getBindingDescription(format).stride * vertexCount);
+        encodeVertices(firstVertex, vertexCount, vertexData.data());
+        arena.upload(allocation, GeometryStream::Vertex, vertexData.data(), vertexData.size(), static_cast<uint32_t>(firstVertex));
+        
+        std::vector<glm::vec3> positionData(vertexCount);
+        for (size_t i = 0; i < vertexCount; i++) {
+            positionData[i] = vertices[firstVertex + i].pos;
+        }
+        arena.upload(allocation, GeometryStream::Position, positionData.data(), sizeof(positionData[0]) * vertexCount, static_cast<uint32_t>(firstVertex));
+        return;
+    }
+    
+    // Every slot has to catch up on the range before it's drawn again
+    for (auto& range : dirtyRanges) {
+        if (range.first == range.second) {
+            range = { firstVertex, firstVertex + vertexCount };
+        } else {
+            range = { std::min(range.first, firstVertex), std::max(range.second, firstVertex + vertexCount) };
+        }
+    }
+    
+    dynamicSlot = (dynamicSlot + 1) % DYNAMIC_BUFFER_COUNT;
+    auto& range = dirtyRanges[dynamicSlot];
     
-    void* data;
-    vkMapMemory(device.device, stagingBuffer.memory, 0, bufferSize, 0, &data);
-    memcpy(data, vertices.data(), (size_t) bufferSize);
-    vkUnmapMemory(device.device, stagingBuffer.memory);
+    auto stride = Vertex::getBindingDescription(format).stride;
+    auto slotVertexData = dynamicVertexData + stride * vertices.size() * dynamicSlot;
+    auto slotPositionData = dynamicPositionData + vertices.size() * dynamicSlot;
     
-    VulkanUtils::copyBuffer(device, stagingBuffer.buffer, vertexBuffer.buffer, bufferSize);
+    encodeVertices(range.first, range.second - range.first, slotVertexData + stride * range.first);
+    for (auto i = range.first; i < range.second; i++) {
+        slotPositionData[i] = vertices[i].pos;
+    }
     
-    device.freeBuffer(stagingBuffer);
+    range = { 0, 0 };
 }
 
-void Mesh::createIndexBuffer() {
-    VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
+std::vector<uint8_t> Mesh::createIndexData() {
+    // All LODs share one index range in the arena, starting with the full mesh
+    std::vector<const std::vector<uint32_t>*> lodIndices = { &indices };
+    for (const auto& lod : lods) {
+        lodIndices.push_back(&lod.indices);
+    }
     
-    VulkanBuffer stagingBuffer;
-    device.createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer);
+    lodRanges.assign(lodIndices.size(), {});
+    bool useShortIndices = true;
+    for (size_t lod = 0; lod < lodIndices.size(); lod++) {
+        useShortIndices = splitIndexRanges(*lodIndices[lod], lodRanges[lod]) && useShortIndices;
+    }
     
-    void* data;
-    vkMapMemory(device.device, stagingBuffer.memory, 0, bufferSize, 0, &data);
-    memcpy(data, indices.data(), (size_t) bufferSize);
-    vkUnmapMemory(device.device, stagingBuffer.memory);
+    if (!useShortIndices) {
+        std::vector<uint32_t> allIndices;
+        for (size_t lod = 0; lod < lodIndices.size(); lod++) {
+            lodRanges[lod] = { { static_cast<uint32_t>(allIndices.size()), static_cast<uint32_t>(lodIndices[lod]->size()), 0 } };
+            allIndices.insert(allIndices.end(), lodIndices[lod]->begin(), lodIndices[lod]->end());
+        }
+        
+        indexType = VK_INDEX_TYPE_UINT32;
+        auto begin = reinterpret_cast<const uint8_t*>(allIndices.data());
+        return std::vector<uint8_t>(begin, begin + sizeof(allIndices[0]) * allIndices.size());
+    }
     
-    device.createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer);
+    // Every range stores its indices relative to its own vertex offset
+    std::vector<uint16_t> allIndices;
+    for (size_t lod = 0; lod < lodIndices.size(); lod++) {
+        auto& source = *lodIndices[lod];
+        auto lodOffset = static_cast<uint32_t>(allIndices.size());
+        
+        for (auto& range : lodRanges[lod]) {
+            for (auto i = range.firstIndex; i < range.firstIndex + range.indexCount; i++) {
+                allIndices.push_back(static_cast<uint16_t>(source[i] - range.vertexOffset));
+            }
+            range.firstIndex += lodOffset;
+        }
+    }
+    
+    indexType = VK_INDEX_TYPE_UINT16;
+    auto begin = reinterpret_cast<const uint8_t*>(allIndices.data());
+    return std::vector<uint8_t>(begin, begin + sizeof(allIndices[0]) * allIndices.size());
+}
+
+bool Mesh::splitIndexRanges(const std::vector<uint32_t>& lodIndices, std::vector<IndexRange>& ranges) {
+    const uint32_t maxVertexSpan = std::numeric_limits<uint16_t>::max() + 1;
+    ranges.clear();
     
-    VulkanUtils::copyBuffer(device, stagingBuffer.buffer, indexBuffer.buffer, bufferSize);
+    if (lodIndices.empty()) {
+        return true;
+    }
+    if (vertices.size() <= maxVertexSpan) {
+        ranges = { { 0, static_cast<uint32_t>(lodIndices.size()), 0 } };
+        return true;
+    }
+    
+    // Start a new range whenever a triangle would stretch the current one past 65536 vertices. This works well after
+    // MeshOptimizer::optimizeVertexFetch, which keeps the vertices of consecutive triangles close together.
+    IndexRange range = { 0, 0, 0 };
+    auto minVertex = std::numeric_limits<uint32_t>::max();
+    auto maxVertex = 0u;
+    
+    for (size_t i = 0; i < lodIndices.size(); i += 3) {
+        auto triangleMin = std::min({ lodIndices[i], lodIndices[i + 1], lodIndices[i + 2] });
+        auto triangleMax = std::max({ lodIndices[i], lodIndices[i + 1], lodIndices[i + 2] });
+        if (triangleMax - triangleMin >= maxVertexSpan) {
+            return false;
+        }
+        
+        auto newMin = std::min(minVertex, triangleMin);
+        auto newMax = std::max(maxVertex, triangleMax);
+        
+        if (range.indexCount > 0 && newMax - newMin >= maxVertexSpan) {
+            range.vertexOffset = static_cast<int32_t>(minVertex);
+            ranges.push_back(range);
+            
+            range = { static_cast<uint32_t>(i), 0, 0 };
+            newMin = triangleMin;
+            newMax = triangleMax;
+        }
+        
+        minVertex = newMin;
+        maxVertex = newMax;
+        range.indexCount += 3;
+    }
+    range.vertexOffset = static_cast<int32_t>(minVertex);
+    ranges.push_back(range);
     
-    device.freeBuffer(stagingBuffer);
+    return ranges.size() * MIN_TRIANGLES_PER_RANGE <= lodIndices.size() / 3;
+}
+
+uint32_t Mesh::selectLod(float pixelsPerUnit, float maxPixelError) const {
+    // The coarsest LOD whose deviation from the full mesh still stays below the threshold on screen
+    uint32_t selected = 0;
+    for (size_t lod = 0; lod < lods.size(); lod++) {
+        if (lods[lod].error * pixelsPerUnit <= maxPixelError) {
+            selected = static_cast<uint32_t>(lod + 1);
+        }
+    }
+    return selected;
 }
 
 void Mesh::bindBuffers(VkCommandBuffer commandBuffer) {
-    VkBuffer vertexBuffers[] = {vertexBuffer.buffer};
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+    arena.bindBuffers(commandBuffer, indexType);
     
-    vkCmdBindIndexBuffer(commandBuffer, indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+    // The index buffer stays the arena's, only the vertices come from the slot written last
+    if (usage == MeshUsage::Dynamic) {
+        VkBuffer vertexBuffers[] = {dynamicVertexBuffer.buffer};
+        VkDeviceSize offsets[] = {Vertex::getBindingDescription(format).stride * vertices.size() * dynamicSlot};
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+    }
 }
 
-void Mesh::draw(VkCommandBuffer commandBuffer) {
-    vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+void Mesh::bindDepthBuffers(VkCommandBuffer commandBuffer) {
+    arena.bindDepthBuffers(commandBuffer, indexType);
+    
+    if (usage == MeshUsage::Dynamic) {
+        VkBuffer vertexBuffers[] = {dynamicPositionBuffer.buffer, dynamicBoneBuffer.buffer};
+        VkDeviceSize offsets[] = {sizeof(glm::vec3) * vertices.size() * dynamicSlot, 0};
+        vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
+    }
+}
+
+const void* Mesh::getBindingKey() const {
+    return usage == MeshUsage::Dynamic ? static_cast<const void*>(this) : static_cast<const void*>(&arena);
+}
+
+void Mesh::draw(VkCommandBuffer commandBuffer, uint32_t lod) {
+    for (const auto& range : lodRanges[std::min(static_cast<size_t>(lod), lodRanges.size() - 1)]) {
+        vkCmdDrawIndexed(commandBuffer, range.indexCount, 1, allocation.firstIndex + range.firstIndex,
+                         static_cast<int32_t>(allocation.firstVertex) + range.vertexOffset, 0);
+    }
+}
+
+void Mesh::calculateBounds() {
+    bounds = {glm::vec3(0.0f), glm::vec3(0.0f)};
+    if (vertices.empty()) {
+        return;
+    }
+    
+    bounds = {vertices[0].pos, vertices[0].pos};
+    growBounds(0, vertices.size());
+}
+
+void Mesh::growBounds(size_t firstVertex, size_t vertexCount) {
+    for (size_t i = firstVertex; i < firstVertex + vertexCount; i++) {
+        bounds.min = glm::min(bounds.min, vertices[i].pos);
+        bounds.max = glm::max(bounds.max, vertices[i].pos);
+    }
 }
 
 void Mesh::calculateTangents() {
@@ -134,6 +373,52 @@ void Mesh::calculateTangents() {
     }
 }
 
+void Mesh::drawRanges(VkCommandBuffer commandBuffer, const std::vector<IndexRange>& ranges) {
+    // Both lists are sorted, clip every range against the 16-bit ranges of LOD 0 to get its vertex offset
+    auto& baseRanges = lodRanges[0];
+    size_t base = 0;
+    
+    for (const auto& range : ranges) {
+        auto end = range.firstIndex + range.indexCount;
+        while (base < baseRanges.size() && baseRanges[base].firstIndex + baseRanges[base].indexCount <= range.firstIndex) {
+            base++;
+        }
+        
+        for (auto b = base; b < baseRanges.size() && baseRanges[b].firstIndex < end; b++) {
+            auto first = std::max(range.firstIndex, baseRanges[b].firstIndex);
+            auto last = std::min(end, baseRanges[b].firstIndex + baseRanges[b].indexCount);
+            vkCmdDrawIndexed(commandBuffer, last - first, 1, allocation.firstIndex + first,
+                             static_cast<int32_t>(allocation.firstVertex) + baseRanges[b].vertexOffset, 0);
+        }
+    }
+}
+
+void Mesh::cullMeshlets(const Frustum& frustum, glm::vec3 cameraPosition, std::vector<IndexRange>& ranges, MeshletStats& stats) const {
+    ranges.clear();
+    
+    for (const auto& meshlet : meshlets) {
+        if (!frustum.intersectsSphere(meshlet.center, meshlet.radius)) {
+            stats.frustumCulledMeshlets++;
+            continue;
+        }
+        
+        auto offset = meshlet.center - cameraPosition;
+        if (glm::dot(offset, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(offset) + meshlet.radius) {
+            stats.backfaceCulledMeshlets++;
+            continue;
+        }
+        
+        stats.visibleMeshlets++;
+        stats.submittedTriangles += meshlet.indexCount / 3;
+        
+        if (!ranges.empty() && ranges.back().firstIndex + ranges.back().indexCount == meshlet.firstIndex) {
+            ranges.back().indexCount += meshlet.indexCount;
+        } else {
+            ranges.push_back({ meshlet.firstIndex, meshlet.indexCount, 0 });
+        }
+    }
+}
+
 std::vector<std::array<glm::vec3, 3>> Mesh::getAllTriangles() {
     std::vector<std::array<glm::vec3, 3>> triangles;
     triangles.resize(indices.size() / 3);
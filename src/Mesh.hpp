@@ -6,7 +6,10 @@
 
 #include "VulkanDevice.hpp"
 #include "VulkanBuffer.hpp"
+#include "GeometryArena.hpp"
 #include "Vertex.hpp"
+#include "Meshlet.hpp"
+#include "Frustum.hpp"
 
 struct MeshBoneData {
     std::string name;
@@ -17,36 +20,128 @@ struct MeshBoneData {
     MeshBoneData(std::string name, uint32_t index, glm::mat4 offset) : name(name), index(index), offset(offset) {}
 };
 
+/** Part of the index buffer drawn with its own vertex offset, so 16-bit indices can address meshes with more vertices */
+struct IndexRange {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    int32_t vertexOffset;
+};
+
+/** Simplified index list over the mesh's vertices, error is its largest deviation from the full mesh in model units */
+struct MeshLod {
+    std::vector<uint32_t> indices;
+    float error;
+};
+
+enum class MeshUsage {
+    Static, // Uploaded once into the geometry arena
+    Dynamic // Vertices rewritten from the CPU every frame, kept in persistently mapped host memory
+};
+
+struct MeshLodSettings {
+    float maxPixelError = 1.0f; // Largest deviation from the full mesh allowed on screen, in pixels
+    int32_t forcedLod = -1; // Draws every mesh at this LOD (clamped to the available ones) when not negative
+};
+
 class Mesh {
     
 public:
-    Mesh(VulkanDevice& device, std::vector<Vertex> vertices, std::vector<uint32_t> indices, std::unordered_map<std::string, MeshBoneData> boneData);
+    Mesh(VulkanDevice& device, std::vector<Vertex> vertices, std::vector<uint32_t> indices, std::unordered_map<std::string, MeshBoneData> boneData,
+         VertexFormat format = VertexFormat::Full, std::vector<MeshLod> lods = {}, std::vector<Meshlet> meshlets = {},
+         MeshUsage usage = MeshUsage::Static);
     virtual ~Mesh();
     
+    /** Binds the arena's buffers, which stay valid for every other mesh with the same arena and index type */
     void bindBuffers(VkCommandBuffer commandBuffer);
-    void draw(VkCommandBuffer commandBuffer);
+    
+    /** Binds only the position stream (binding 0) and the bone stream (binding 1) for depth-only passes */
+    void bindDepthBuffers(VkCommandBuffer commandBuffer);
+    
+    /** Meshes with the same binding key and index type can be drawn one after another without rebinding */
+    const void* getBindingKey() const;
+    void draw(VkCommandBuffer commandBuffer, uint32_t lod = 0);
+    
+    /** Draws parts of LOD 0, as produced by cullMeshlets */
+    void drawRanges(VkCommandBuffer commandBuffer, const std::vector<IndexRange>& ranges);
+    
+    /**
+     * Collects the LOD 0 index ranges of meshlets inside the frustum and not facing away from the camera, merging
+     * neighbouring ones. Frustum and camera position are in model space.
+     */
+    void cullMeshlets(const Frustum& frustum, glm::vec3 cameraPosition, std::vector<IndexRange>& ranges, MeshletStats& stats) const;
     void calculateTangents();
     
     MeshBoneData& getBoneData(std::string boneName) { return boneData[boneName]; }
     std::unordered_map<std::string, MeshBoneData>& getBoneData() { return boneData; }
-    std::vector<glm::mat4>& getBoneTransforms() { return boneTransforms; }
     std::vector<std::array<glm::vec3, 3>> getAllTriangles();
+    const std::vector<uint32_t>& getIndices() const { return indices; }
+    VertexFormat getVertexFormat() const { return format; }
+    VkIndexType getIndexType() const { return indexType; }
+    const GeometryArena& getGeometryArena() const { return arena; }
+    const GeometryAllocation& getGeometryAllocation() const { return allocation; }
+    const std::vector<IndexRange>& getIndexRanges(uint32_t lod = 0) const { return lodRanges[lod]; }
+    
+    /** Number of LODs including the full mesh, which is LOD 0 */
+    uint32_t getLodCount() const { return static_cast<uint32_t>(lodRanges.size()); }
+    
+    /** Picks the coarsest LOD that deviates by at most maxPixelError pixels, when one model unit covers pixelsPerUnit */
+    uint32_t selectLod(float pixelsPerUnit, float maxPixelError) const;
+    bool hasBoneStream() const { return boneStream; }
+    bool hasMeshlets() const { return !meshlets.empty(); }
+    const std::vector<Meshlet>& getMeshlets() const { return meshlets; }
+    
+    /** Bounds of the vertices, kept up to date by updateVertexBuffer but not deformed by GPU skinning */
+    const BoundingBox& getBounds() const { return bounds; }
 
+    /**
+     * Uploads vertices after they were changed on the CPU. Static meshes go through a staging copy that waits for frames in
+     * flight to finish reading their vertices, dynamic meshes write straight into the next ring slot, which is only safe
+     * once per frame.
+     */
     void updateVertexBuffer();
+    void updateVertexBuffer(size_t firstVertex, size_t vertexCount);
+    MeshUsage getUsage() const { return usage; }
     
     std::vector<Vertex> vertices;
 private:
     VulkanDevice& device;
 
     std::vector<uint32_t> indices;
+    std::vector<MeshLod> lods;
+    std::vector<Meshlet> meshlets;
     std::unordered_map<std::string, MeshBoneData> boneData;
+    VertexFormat format;
+    MeshUsage usage;
+    bool boneStream;
+    VkIndexType indexType;
+    std::vector<std::vector<IndexRange>> lodRanges; // Relative to the allocation
+    BoundingBox bounds;
     
-    // TODO: allow for seperate transforms with reused meshes
-    std::vector<glm::mat4> boneTransforms;
+    GeometryArena& arena;
+    GeometryAllocation allocation;
     
-    VulkanBuffer vertexBuffer;
-    VulkanBuffer indexBuffer;
+    // One more slot than frames in flight, as updates happen before the renderer waits for the oldest frame
+    static const uint32_t DYNAMIC_BUFFER_COUNT = 3;
     
+    VulkanBuffer dynamicVertexBuffer;
+    VulkanBuffer dynamicPositionBuffer;
+    VulkanBuffer dynamicBoneBuffer;
+    uint8_t* dynamicVertexData = nullptr;
+    glm::vec3* dynamicPositionData = nullptr;
+    uint32_t dynamicSlot = 0;
+    std::array<std::pair<size_t, size_t>, DYNAMIC_BUFFER_COUNT> dirtyRanges; // Vertices each slot is missing, [first, second)
+    
+    std::vector<uint8_t> getVertexData();
+    std::vector<glm::vec3> getPositionData();
+    std::vector<uint8_t> getBoneStreamData();
     void createVertexBuffer();
-    void createIndexBuffer();
+    void createDynamicBuffers();
+    void encodeVertices(size_t firstVertex, size_t vertexCount, uint8_t* target);
+    std::vector<uint8_t> createIndexData();
+    void calculateBounds();
+    void growBounds(size_t firstVertex, size_t vertexCount);
+    bool splitIndexRanges(const std::vector<uint32_t>& lodIndices, std::vector<IndexRange>& ranges);
+    
+    // Ranges shorter than this on average aren't worth the extra draw calls, such meshes keep 32-bit indices
+    static const uint32_t MIN_TRIANGLES_PER_RANGE = 1024;
 };
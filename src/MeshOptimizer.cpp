@@ -0,0 +1,602 @@
+#include "MeshOptimizer.hpp"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+
+size_t MeshOptimizer::weldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, float epsilon) {
+    std::unordered_map<Vertex, uint32_t> uniqueVertices;
+    uniqueVertices.reserve(vertices.size());
+
+    std::vector<uint32_t> remap(vertices.size());
+    std::vector<Vertex> weldedVertices;
+    weldedVertices.reserve(vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); i++) {
+        auto key = epsilon > 0.0f ? quantize(vertices[i], epsilon) : vertices[i];
+        auto result = uniqueVertices.emplace(key, static_cast<uint32_t>(weldedVertices.size()));
+
+        // The first vertex of a group is kept unchanged, later ones only point to it
+        if (result.second) {
+            weldedVertices.push_back(vertices[i]);
+        }
+        remap[i] = result.first->second;
+    }
+
+    for (auto& index : indices) {
+        index = remap[index];
+    }
+
+    auto removed = vertices.size() - weldedVertices.size();
+    vertices = std::move(weldedVertices);
+    return removed;
+}
+
+Vertex MeshOptimizer::quantize(const Vertex& vertex, float epsilon) {
+    // Adding 0 turns -0 into +0, so both land in the same cell
+    auto snap = [epsilon](float value) {
+        return std::round(value / epsilon) * epsilon + 0.0f;
+    };
+
+    Vertex quantized = vertex;
+    for (int i = 0; i < 3; i++) {
+        quantized.pos[i] = snap(vertex.pos[i]);
+        quantized.normal[i] = snap(vertex.normal[i]);
+    }
+    for (int i = 0; i < 4; i++) {
+        quantized.color[i] = snap(vertex.color[i]);
+        quantized.tangent[i] = snap(vertex.tangent[i]);
+    }
+    for (int i = 0; i < 2; i++) {
+        quantized.texCoord[i] = snap(vertex.texCoord[i]);
+    }
+    for (size_t i = 0; i < Vertex::BONES_PER_VERTEX; i++) {
+        quantized.boneWeights[i] = snap(vertex.boneWeights[i]);
+    }
+    return quantized;
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>* clusters) {
+    auto triangleCount = indices.size() / 3;
+    if (clusters != nullptr) {
+        clusters->clear();
+    }
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // Triangles using each vertex, as one flat array indexed by adjacencyOffsets
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (auto index : indices) {
+        liveTriangles[index]++;
+    }
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++) {
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+    }
+
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); i++) {
+        adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+
+    uint32_t timestamp = VERTEX_CACHE_SIZE + 1;
+    uint32_t cursor = 0;
+    int64_t fanningVertex = indices[0];
+
+    while (fanningVertex >= 0) {
+        candidates.clear();
+
+        // Emit all remaining triangles around the fanning vertex
+        for (auto a = adjacencyOffsets[fanningVertex]; a < adjacencyOffsets[fanningVertex + 1]; a++) {
+            auto triangle = adjacency[a];
+            if (emitted[triangle]) {
+                continue;
+            }
+
+            for (int corner = 0; corner < 3; corner++) {
+                auto vertex = indices[triangle * 3 + corner];
+                result.push_back(vertex);
+                deadEnds.push_back(vertex);
+                candidates.push_back(vertex);
+                liveTriangles[vertex]--;
+
+                if (timestamp - cacheTimestamps[vertex] > VERTEX_CACHE_SIZE) {
+                    cacheTimestamps[vertex] = timestamp++;
+                }
+            }
+            emitted[triangle] = true;
+        }
+
+        // Prefer the candidate that stays in the cache longest while its remaining triangles are emitted
+        fanningVertex = -1;
+        int64_t bestPriority = -1;
+        for (auto vertex : candidates) {
+            if (liveTriangles[vertex] == 0) {
+                continue;
+            }
+
+            int64_t priority = 0;
+            if (timestamp - cacheTimestamps[vertex] + 2 * liveTriangles[vertex] <= VERTEX_CACHE_SIZE) {
+                priority = timestamp - cacheTimestamps[vertex];
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                fanningVertex = vertex;
+            }
+        }
+
+        if (fanningVertex >= 0) {
+            continue;
+        }
+
+        // Dead end: continue from a recently used vertex, or the next one in input order that still has triangles
+        while (!deadEnds.empty() && fanningVertex < 0) {
+            auto vertex = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveTriangles[vertex] > 0) {
+                fanningVertex = vertex;
+            }
+        }
+        while (fanningVertex < 0 && cursor < vertexCount) {
+            if (liveTriangles[cursor] > 0) {
+                fanningVertex = cursor;
+            }
+            cursor++;
+        }
+
+        if (fanningVertex >= 0 && clusters != nullptr) {
+            clusters->push_back(static_cast<uint32_t>(result.size() / 3));
+        }
+    }
+
+    if (clusters != nullptr) {
+        clusters->insert(clusters->begin(), 0);
+    }
+    indices = std::move(result);
+}
+
+void MeshOptimizer::optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& clusters, float threshold) {
+    auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    if (clusters.size() < 2) {
+        return;
+    }
+
+    glm::vec3 meshCentroid(0.0f);
+    for (const auto& vertex : vertices) {
+        meshCentroid += vertex.pos;
+    }
+    meshCentroid /= static_cast<float>(std::max<size_t>(vertices.size(), 1));
+
+    struct Cluster {
+        uint32_t begin;
+        uint32_t end;
+        float sortKey;
+    };
+
+    std::vector<Cluster> sortedClusters;
+    for (size_t c = 0; c < clusters.size(); c++) {
+        Cluster cluster = {};
+        cluster.begin = clusters[c];
+        cluster.end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+        // Area-weighted centroid and normal of the cluster
+        glm::vec3 centroid(0.0f);
+        glm::vec3 normal(0.0f);
+        float area = 0.0f;
+        for (auto t = cluster.begin; t < cluster.end; t++) {
+            auto& p0 = vertices[indices[t * 3 + 0]].pos;
+            auto& p1 = vertices[indices[t * 3 + 1]].pos;
+            auto& p2 = vertices[indices[t * 3 + 2]].pos;
+
+            auto triangleNormal = glm::cross(p1 - p0, p2 - p0);
+            auto triangleArea = glm::length(triangleNormal);
+            centroid += (p0 + p1 + p2) / 3.0f * triangleArea;
+            normal += triangleNormal;
+            area += triangleArea;
+        }
+
+        if (area > 0.0f) {
+            centroid /= area;
+        }
+        auto normalLength = glm::length(normal);
+        if (normalLength > 0.0f) {
+            normal /= normalLength;
+        }
+
+        cluster.sortKey = glm::dot(centroid - meshCentroid, normal);
+        sortedClusters.push_back(cluster);
+    }
+
+    std::stable_sort(sortedClusters.begin(), sortedClusters.end(), [](const Cluster& a, const Cluster& b) {
+        return a.sortKey > b.sortKey;
+    });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (const auto& cluster : sortedClusters) {
+        result.insert(result.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+    }
+
+    auto before = analyzeVertexCache(indices, vertices.size()).acmr;
+    auto after = analyzeVertexCache(result, vertices.size()).acmr;
+    if (after <= before * threshold) {
+        indices = std::move(result);
+    }
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    const auto unused = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> remap(vertices.size(), unused);
+    std::vector<Vertex> result;
+    result.reserve(vertices.size());
+
+    for (auto& index : indices) {
+        if (remap[index] == unused) {
+            remap[index] = static_cast<uint32_t>(result.size());
+            result.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    // Vertices no index refers to are dropped
+    vertices = std::move(result);
+}
+
+VertexCacheStatistics MeshOptimizer::analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+    VertexCacheStatistics statistics = {};
+    if (indices.empty()) {
+        return statistics;
+    }
+
+    // Entry time of every vertex in the FIFO, a vertex is cached while fewer than cacheSize misses happened since
+    std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    uint32_t misses = 0;
+    size_t uniqueVertices = 0;
+
+    for (auto index : indices) {
+        if (cacheTimestamps[index] == 0 || misses + 1 - cacheTimestamps[index] > cacheSize) {
+            misses++;
+            cacheTimestamps[index] = misses;
+        }
+
+        if (!referenced[index]) {
+            referenced[index] = true;
+            uniqueVertices++;
+        }
+    }
+
+    statistics.acmr = static_cast<float>(misses) / (indices.size() / 3);
+    statistics.atvr = static_cast<float>(misses) / uniqueVertices;
+    return statistics;
+}
+
+/** Symmetric 4x4 matrix summing squared distances to a set of planes, weighted by triangle area */
+struct Quadric {
+    double a00, a01, a02, a03, a11, a12, a13, a22, a23, a33;
+    double weight;
+
+    static Quadric fromPlane(glm::vec3 normal, float distance, float weight) {
+        double a = normal.x, b = normal.y, c = normal.z, d = distance;
+        return { a * a * weight, a * b * weight, a * c * weight, a * d * weight, b * b * weight, b * c * weight,
+                 b * d * weight, c * c * weight, c * d * weight, d * d * weight, weight };
+    }
+
+    Quadric& operator+=(const Quadric& other) {
+        a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03; a11 += other.a11;
+        a12 += other.a12; a13 += other.a13; a22 += other.a22; a23 += other.a23; a33 += other.a33;
+        weight += other.weight;
+        return *this;
+    }
+
+    /** Mean squared distance of the point to the planes */
+    double evaluate(glm::vec3 p) const {
+        double x = p.x, y = p.y, z = p.z;
+        double sum = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x
+                   + a11 * y * y + 2 * a12 * y * z + 2 * a13 * y
+                   + a22 * z * z + 2 * a23 * z + a33;
+        return weight > 0.0 ? std::max(sum, 0.0) / weight : 0.0;
+    }
+};
+
+std::vector<uint32_t> MeshOptimizer::simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float targetError, float* resultError) {
+    auto vertexCount = vertices.size();
+    std::vector<uint32_t> result = indices;
+    float maxError = 0.0f;
+
+    // Welded vertices sharing a position differ in UV, normal or weights, so they sit on a seam
+    std::unordered_map<glm::vec3, uint32_t> positionUses;
+    for (const auto& vertex : vertices) {
+        positionUses[vertex.pos]++;
+    }
+
+    std::vector<bool> locked(vertexCount, false);
+    for (size_t v = 0; v < vertexCount; v++) {
+        locked[v] = positionUses[vertices[v].pos] > 1;
+    }
+
+    // Edges used by a single triangle are on an open border
+    std::unordered_map<uint64_t, uint32_t> edgeUses;
+    for (size_t i = 0; i < result.size(); i += 3) {
+        for (int e = 0; e < 3; e++) {
+            uint64_t a = result[i + e], b = result[i + (e + 1) % 3];
+            edgeUses[std::min(a, b) << 32 | std::max(a, b)]++;
+        }
+    }
+    for (const auto& edge : edgeUses) {
+        if (edge.second == 1) {
+            locked[edge.first >> 32] = true;
+            locked[edge.first & 0xffffffff] = true;
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount, Quadric());
+    for (size_t i = 0; i < result.size(); i += 3) {
+        auto& p0 = vertices[result[i + 0]].pos;
+        auto& p1 = vertices[result[i + 1]].pos;
+        auto& p2 = vertices[result[i + 2]].pos;
+
+        auto normal = glm::cross(p1 - p0, p2 - p0);
+        auto length = glm::length(normal);
+        if (length == 0.0f) {
+            continue;
+        }
+        normal /= length;
+
+        auto quadric = Quadric::fromPlane(normal, -glm::dot(normal, p0), length * 0.5f);
+        for (int corner = 0; corner < 3; corner++) {
+            quadrics[result[i + corner]] += quadric;
+        }
+    }
+
+    struct Collapse {
+        uint32_t from;
+        uint32_t to;
+        float error; // Squared
+    };
+
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<bool> touched(vertexCount);
+
+    // Replacing from with to must not turn any remaining triangle around from upside down
+    auto flipsTriangles = [&](uint32_t from, uint32_t to) {
+        for (auto a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1]; a++) {
+            auto triangle = &result[adjacency[a] * 3];
+            if (triangle[0] == to || triangle[1] == to || triangle[2] == to) {
+                continue;
+            }
+
+            glm::vec3 before[3], after[3];
+            for (int corner = 0; corner < 3; corner++) {
+                before[corner] = vertices[triangle[corner]].pos;
+                after[corner] = triangle[corner] == from ? vertices[to].pos : before[corner];
+            }
+
+            auto normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+            auto normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+            if (glm::dot(normalBefore, normalAfter) <= 0.0f) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // Every pass collapses the cheapest edges, each vertex at most once, until the target is reached or nothing changes
+    while (result.size() > targetIndexCount) {
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (auto index : result) {
+            adjacencyOffsets[index + 1]++;
+        }
+        std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+
+        adjacency.resize(result.size());
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < result.size(); i++) {
+            adjacency[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i += 3) {
+            for (int e = 0; e < 3; e++) {
+                uint32_t edge[2] = { result[i + e], result[i + (e + 1) % 3] };
+
+                for (int direction = 0; direction < 2; direction++) {
+                    auto from = edge[direction], to = edge[1 - direction];
+                    if (locked[from] || getInfluenceDelta(vertices[from], vertices[to]) > MAX_INFLUENCE_DELTA) {
+                        continue;
+                    }
+
+                    auto quadric = quadrics[from];
+                    quadric += quadrics[to];
+                    collapses.push_back({ from, to, static_cast<float>(quadric.evaluate(vertices[to].pos)) });
+                }
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+            return a.error < b.error;
+        });
+
+        std::iota(remap.begin(), remap.end(), 0);
+        std::fill(touched.begin(), touched.end(), false);
+
+        // Most collapses remove two triangles
+        auto trianglesToRemove = (result.size() - targetIndexCount) / 3;
+        size_t removedEstimate = 0;
+        size_t collapseCount = 0;
+
+        for (const auto& collapse : collapses) {
+            if (collapse.error > targetError * targetError || removedEstimate >= trianglesToRemove) {
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to] || flipsTriangles(collapse.from, collapse.to)) {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            touched[collapse.from] = true;
+            touched[collapse.to] = true;
+            quadrics[collapse.to] += quadrics[collapse.from];
+
+            maxError = std::max(maxError, std::sqrt(collapse.error));
+            removedEstimate += 2;
+            collapseCount++;
+        }
+
+        if (collapseCount == 0) {
+            break;
+        }
+
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3) {
+            auto a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+            if (a == b || b == c || a == c) {
+                continue;
+            }
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    if (resultError != nullptr) {
+        *resultError = maxError;
+    }
+    return result;
+}
+
+float MeshOptimizer::getInfluenceDelta(const Vertex& a, const Vertex& b) {
+    auto weightOf = [](const Vertex& vertex, uint32_t boneId) {
+        float weight = 0.0f;
+        for (size_t i = 0; i < Vertex::BONES_PER_VERTEX; i++) {
+            if (vertex.boneIds[i] == boneId) {
+                weight += vertex.boneWeights[i];
+            }
+        }
+        return weight;
+    };
+
+    // Bones of a are compared against b, bones only b uses are counted in full
+    float delta = 0.0f;
+    for (size_t i = 0; i < Vertex::BONES_PER_VERTEX; i++) {
+        if (a.boneWeights[i] != 0.0f) {
+            delta += std::abs(a.boneWeights[i] - weightOf(b, a.boneIds[i]));
+        }
+        if (b.boneWeights[i] != 0.0f && weightOf(a, b.boneIds[i]) == 0.0f) {
+            delta += b.boneWeights[i];
+        }
+    }
+    return delta;
+}
+
+std::vector<Meshlet> MeshOptimizer::buildMeshlets(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, uint32_t maxVertices, uint32_t maxTriangles) {
+    std::vector<Meshlet> meshlets;
+    if (indices.empty()) {
+        return meshlets;
+    }
+
+    // Last meshlet each vertex was added to, for counting unique vertices without clearing a set
+    std::vector<uint32_t> vertexMeshlet(vertices.size(), std::numeric_limits<uint32_t>::max());
+    Meshlet meshlet = {};
+    uint32_t vertexCount = 0;
+
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        auto meshletIndex = static_cast<uint32_t>(meshlets.size());
+        auto newVertices = 0u;
+        for (int corner = 0; corner < 3; corner++) {
+            newVertices += vertexMeshlet[indices[i + corner]] != meshletIndex;
+        }
+
+        if (meshlet.indexCount / 3 + 1 > maxTriangles || vertexCount + newVertices > maxVertices) {
+            computeMeshletBounds(vertices, indices, meshlet);
+            meshlets.push_back(meshlet);
+
+            meshletIndex++;
+            meshlet = {};
+            meshlet.firstIndex = static_cast<uint32_t>(i);
+            vertexCount = 0;
+            newVertices = 0;
+            for (int corner = 0; corner < 3; corner++) {
+                newVertices += vertexMeshlet[indices[i + corner]] != meshletIndex;
+            }
+        }
+
+        for (int corner = 0; corner < 3; corner++) {
+            vertexMeshlet[indices[i + corner]] = meshletIndex;
+        }
+        vertexCount += newVertices;
+        meshlet.indexCount += 3;
+    }
+
+    computeMeshletBounds(vertices, indices, meshlet);
+    meshlets.push_back(meshlet);
+    return meshlets;
+}
+
+void MeshOptimizer::computeMeshletBounds(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, Meshlet& meshlet) {
+    auto begin = indices.begin() + meshlet.firstIndex;
+    auto end = begin + meshlet.indexCount;
+
+    glm::vec3 minPosition(std::numeric_limits<float>::max());
+    glm::vec3 maxPosition(std::numeric_limits<float>::lowest());
+    for (auto index = begin; index != end; index++) {
+        minPosition = glm::min(minPosition, vertices[*index].pos);
+        maxPosition = glm::max(maxPosition, vertices[*index].pos);
+    }
+
+    meshlet.center = (minPosition + maxPosition) * 0.5f;
+    meshlet.radius = 0.0f;
+    for (auto index = begin; index != end; index++) {
+        meshlet.radius = std::max(meshlet.radius, glm::length(vertices[*index].pos - meshlet.center));
+    }
+
+    std::vector<glm::vec3> normals;
+    glm::vec3 axis(0.0f);
+    for (auto index = begin; index != end; index += 3) {
+        auto& p0 = vertices[index[0]].pos;
+        auto& p1 = vertices[index[1]].pos;
+        auto& p2 = vertices[index[2]].pos;
+
+        // Oriented by the vertex normals, so the cone doesn't depend on the winding convention
+        auto normal = glm::cross(p1 - p0, p2 - p0);
+        auto vertexNormal = vertices[index[0]].normal + vertices[index[1]].normal + vertices[index[2]].normal;
+        if (glm::dot(normal, vertexNormal) < 0.0f) {
+            normal = -normal;
+        }
+
+        auto length = glm::length(normal);
+        if (length > 0.0f) {
+            normals.push_back(normal / length);
+            axis += normals.back();
+        }
+    }
+
+    auto axisLength = glm::length(axis);
+    meshlet.coneAxis = axisLength > 0.0f ? axis / axisLength : glm::vec3(0.0f, 0.0f, 1.0f);
+    meshlet.coneCutoff = 1.0f;
+
+    // The cone is only useful while every normal is less than 90 degrees from the axis
+    auto minDot = 1.0f;
+    for (const auto& normal : normals) {
+        minDot = std::min(minDot, glm::dot(normal, meshlet.coneAxis));
+    }
+    if (!normals.empty() && minDot > 0.0f) {
+        meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+    }
+}
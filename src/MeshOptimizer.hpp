@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "Vertex.hpp"
+#include "Meshlet.hpp"
+
+struct VertexCacheStatistics {
+    float acmr; // Average cache miss ratio: transformed vertices per triangle, 0.5 at best, 3 at worst
+    float atvr; // Average transformed vertex ratio: transformed vertices per unique vertex, 1 at best
+};
+
+/** Import-time passes over indexed triangle lists, run by ModelLoader before meshes are uploaded */
+class MeshOptimizer {
+
+public:
+    /**
+     * Merges identical vertices and remaps the indices to the remaining ones. With an epsilon > 0, every attribute is
+     * snapped to a grid of that size before comparing, so nearly identical vertices are merged as well.
+     * Returns the number of vertices removed.
+     */
+    static size_t weldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, float epsilon = 0.0f);
+
+    /**
+     * Reorders triangles for the post-transform vertex cache (Tipsify). If clusters isn't null, it receives the
+     * triangle index of every point where the cache was restarted, which optimizeOverdraw sorts on.
+     */
+    static void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>* clusters = nullptr);
+
+    /**
+     * Sorts the clusters from optimizeVertexCache so outward facing clusters on the outside of the mesh come first
+     * and occlude the rest. The new order is kept only if it raises the ACMR by less than the given factor.
+     */
+    static void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& clusters, float threshold = 1.05f);
+
+    /** Reorders vertices by first use in the index buffer, so vertex fetches walk memory linearly */
+    static void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+    /** Simulates a FIFO post-transform cache of the given size */
+    static VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+    /**
+     * Quadric error edge collapse, down to targetIndexCount indices or until the cheapest collapse would move the surface
+     * further than targetError (in model units). A collapse keeps the surviving vertex unchanged, so attributes and bone
+     * weights stay valid; seam and border vertices are locked and vertices with different bone influences aren't merged.
+     * resultError receives the largest deviation of any collapse that was made.
+     */
+    static std::vector<uint32_t> simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+    /**
+     * Splits the triangles into meshlets in index order, so each one is a contiguous index range. Runs after
+     * optimizeVertexCache, whose fans keep consecutive triangles close together.
+     */
+    static std::vector<Meshlet> buildMeshlets(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+                                              uint32_t maxVertices = Meshlet::MAX_VERTICES, uint32_t maxTriangles = Meshlet::MAX_TRIANGLES);
+
+    static const uint32_t VERTEX_CACHE_SIZE = 16;
+
+private:
+    // Largest summed bone weight difference between two vertices that simplify still merges
+    static constexpr float MAX_INFLUENCE_DELTA = 0.25f;
+
+    static float getInfluenceDelta(const Vertex& a, const Vertex& b);
+    static void computeMeshletBounds(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, Meshlet& meshlet);
+
+    static Vertex quantize(const Vertex& vertex, float epsilon);
+
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+/** Small cluster of a mesh's triangles, contiguous in its LOD 0 index list, with the bounds for culling it */
+struct Meshlet {
+    static const uint32_t MAX_VERTICES = 64;
+    static const uint32_t MAX_TRIANGLES = 124;
+
+    uint32_t firstIndex;
+    uint32_t indexCount;
+
+    // Bounding sphere in model space
+    glm::vec3 center;
+    float radius;
+
+    // Normal cone, all triangles face away from a camera where dot(center - camera, coneAxis) >= coneCutoff * distance + radius
+    glm::vec3 coneAxis;
+    float coneCutoff; // 1 if the normals spread too far for the cone to ever cull
+};
+
+/** Per-frame meshlet culling counters, reset at the start of every frame */
+struct MeshletStats {
+    uint32_t visibleMeshlets;
+    uint32_t frustumCulledMeshlets;
+    uint32_t backfaceCulledMeshlets;
+    uint32_t submittedTriangles;
+};
@@ -11,6 +11,8 @@
 #include "VulkanTexture.hpp"
 #include "Vertex.hpp"
 #include "Animation.hpp"
+#include "AnimationState.hpp"
+#include "BakedAnimation.hpp"
 #include "Skeleton.hpp"
 #include "Globals.hpp"
 #include "PipelineSettings.hpp"
@@ -18,12 +20,27 @@
 class Model {
     
 public:
-    Model(std::vector<std::shared_ptr<Mesh>> meshes, std::unordered_map<std::string, Animation> animations,
+    Model(std::vector<std::shared_ptr<Mesh>> meshes, std::shared_ptr<const AnimationClips> animations,
           std::shared_ptr<PipelineSettings> pipelineSettings, std::shared_ptr<Uniforms<LocalTransform>> uniforms,
-          std::unique_ptr<Skeleton> skeleton, VulkanDevice& device)
+          std::shared_ptr<const Skeleton> skeleton, VulkanDevice& device)
             : position(), rotation(), scale(1.0f, 1.0f, 1.0f),
               meshes(meshes), animations(animations), uniforms(uniforms),
-              pipelineSettings(pipelineSettings), skeleton(std::move(skeleton)) {
+              pipelineSettings(pipelineSettings), skeleton(skeleton),
+              bakedAnimations(std::make_shared<BakedAnimationClips>()), device(device) {
+        // The set 1 layout only has the bone palette binding the skinning shaders read if the uniforms were created for it
+        if (this->uniforms->isSkinned() != this->pipelineSettings->skinned) {
+            throw std::runtime_error("The uniforms and the pipeline settings of a model have to agree on skinning.");
+        }
+        if (this->skeleton != nullptr && this->skeleton->getPaletteSize() > 0) {
+            animationState = std::make_unique<AnimationState>(this->skeleton);
+        }
+    }
+    
+    /** Creates another model sharing meshes, skeleton and clips with this one, but with its own uniforms and animation state */
+    std::shared_ptr<Model> createInstance(std::shared_ptr<Uniforms<LocalTransform>> uniforms) {
+        auto instance = std::make_shared<Model>(meshes, animations, pipelineSettings, uniforms, skeleton, device);
+        instance->bakedAnimations = bakedAnimations;
+        return instance;
     }
     
     inline std::vector<std::shared_ptr<Mesh>>& getMeshes() { return meshes; }
@@ -39,24 +56,65 @@ public:
         shadowPipeline.reset();
     }
     
-    void playAnimation(std::string name, float time, int meshIndex = 0) {
-        if (animations.count(name) == 0) {
-            throw std::runtime_error("The animation '" + name + "' doesn't exist.");
+    void playAnimation(std::string name, float time, float fadeDuration = 0.0f) {
+        if (animationState == nullptr) {
+            throw std::runtime_error("The model has no skinned meshes to animate.");
+        }
+        animationState->play(findAnimation(name), time, fadeDuration);
+    }
+    
+    void setAdditiveAnimation(std::string name, float weight) {
+        if (animationState == nullptr) {
+            throw std::runtime_error("The model has no skinned meshes to animate.");
+        }
+        animationState->setAdditive(findAnimation(name), weight);
+    }
+    
+    /** Bakes the clip for this model's skeleton, the result is shared with all instances. Returns the bytes used. */
+    size_t bakeAnimation(std::string name, float sampleRate = 30.0f) {
+        if (skeleton == nullptr) {
+            throw std::runtime_error("The model has no skeleton to bake animations for.");
+        }
+        auto baked = BakedAnimation::bake(*findAnimation(name), *skeleton, sampleRate);
+        (*bakedAnimations)[name] = baked;
+        return baked->getMemorySize();
+    }
+    
+    void playBakedAnimation(std::string name, float time, bool interpolate = true) {
+        if (animationState == nullptr) {
+            throw std::runtime_error("The model has no skinned meshes to animate.");
+        }
+        if (bakedAnimations->count(name) == 0) {
+            throw std::runtime_error("The animation '" + name + "' hasn't been baked.");
         }
-        animations[name].evaluate(*meshes[meshIndex], *skeleton, time);
+        animationState->playBaked(bakedAnimations->at(name), time, interpolate);
     }
+    
+    inline bool hasAnimationState() { return animationState != nullptr; }
+    inline AnimationState& getAnimationState() { return *animationState; }
 
     glm::vec3 position;
     glm::quat rotation;
     glm::vec3 scale;
+    bool frustumCulling = true; // Disable for models not drawn at their transform, like the skybox
     
 private:
     std::vector<std::shared_ptr<Mesh>> meshes;
-    std::unordered_map<std::string, Animation> animations;
+    std::shared_ptr<const AnimationClips> animations;
     std::shared_ptr<Uniforms<LocalTransform>> uniforms;
     std::shared_ptr<Pipeline> pipeline;
     std::shared_ptr<Pipeline> shadowPipeline;
     std::shared_ptr<PipelineSettings> pipelineSettings;
-    std::unique_ptr<Skeleton> skeleton;
+    std::shared_ptr<const Skeleton> skeleton;
+    std::shared_ptr<BakedAnimationClips> bakedAnimations;
+    std::unique_ptr<AnimationState> animationState;
+    VulkanDevice& device;
+    
+    std::shared_ptr<const Animation> findAnimation(const std::string& name) {
+        if (animations == nullptr || animations->count(name) == 0) {
+            throw std::runtime_error("The animation '" + name + "' doesn't exist.");
+        }
+        return animations->at(name);
+    }
 
 };
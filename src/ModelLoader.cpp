@@ -1,6 +1,8 @@
 #include "ModelLoader.hpp"
 
-std::shared_ptr<Model> ModelLoader::fromFile(std::string path, VulkanDevice& device, std::shared_ptr<PipelineSettings> pipelineSettings, std::shared_ptr<Uniforms<LocalTransform>> uniforms, std::string skeletonRoot) {
+#include "UploadQueue.hpp"
+
+std::shared_ptr<Model> ModelLoader::fromFile(std::string path, VulkanDevice& device, std::shared_ptr<PipelineSettings> pipelineSettings, std::shared_ptr<Uniforms<LocalTransform>> uniforms, std::string skeletonRoot, const ModelImportSettings& importSettings) {
     Assimp::Importer importer;
     const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace | aiProcess_LimitBoneWeights | aiProcess_GenSmoothNormals);
     
@@ -8,14 +10,19 @@ std::shared_ptr<Model> ModelLoader::fromFile(std::string path, VulkanDevice& dev
         throw std::runtime_error(std::string("Assimp Error: ") + importer.GetErrorString());
     }
     
-    auto meshes = loadMeshes(scene, device);
-    auto animations = loadAnimations(scene);
-    auto skeleton = loadSkeleton(scene, skeletonRoot);
-    skeleton->getRoot()->print();
-    return std::make_shared<Model>(std::move(meshes), std::move(animations), pipelineSettings, uniforms, std::move(skeleton), device);
+    // Bone indices are shared by all meshes of the model, so one palette per instance covers every mesh
+    std::unordered_map<std::string, MeshBoneData> modelBoneData;
+    auto meshes = loadMeshes(scene, device, pipelineSettings->vertexFormat, importSettings, modelBoneData);
+    auto animations = loadAnimations(scene, importSettings);
+    auto skeleton = loadSkeleton(scene, skeletonRoot, modelBoneData);
+    skeleton->print();
+    
+    // All geometry of the model goes to the GPU in one batch, the renderer doesn't wait for it before the next frame
+    device.uploadQueue->submit();
+    return std::make_shared<Model>(std::move(meshes), animations, pipelineSettings, uniforms, skeleton, device);
 }
 
-std::vector<std::shared_ptr<Mesh>> ModelLoader::loadMeshes(const aiScene *scene, VulkanDevice& device) {
+std::vector<std::shared_ptr<Mesh>> ModelLoader::loadMeshes(const aiScene *scene, VulkanDevice& device, VertexFormat format, const ModelImportSettings& importSettings, std::unordered_map<std::string, MeshBoneData>& modelBoneData) {
     std::vector<aiMesh*> aiMeshes;
     processMeshNodes(scene->mRootNode, scene, aiMeshes);
     if (!aiMeshes.size()) {
@@ -99,13 +106,96 @@ std::vector<std::shared_ptr<Mesh>> ModelLoader::loadMeshes(const aiScene *scene,
             }
         }
         
-        auto meshBoneData = loadMeshBoneData(aiMesh, vertices);
-        meshes.push_back(std::make_shared<Mesh>(device, vertices, indices, meshBoneData));
+        auto meshBoneData = loadMeshBoneData(aiMesh, vertices, modelBoneData);
+        
+        // Welding runs after the bone weights are in place, so vertices with different skinning stay apart
+        if (importSettings.weldVertices) {
+            auto vertexCount = vertices.size();
+            auto removed = MeshOptimizer::weldVertices(vertices, indices, importSettings.weldEpsilon);
+            if (importSettings.verbose) {
+                std::cout << "Mesh '" << aiMesh->mName.C_Str() << "': welded " << vertexCount << " -> " << vertices.size()
+                    << " vertices (" << removed << " removed)" << std::endl;
+            }
+        }
+        
+        if (importSettings.optimizeIndices) {
+            VertexCacheStatistics before = {};
+            if (importSettings.verbose) {
+                before = MeshOptimizer::analyzeVertexCache(indices, vertices.size());
+            }
+            
+            std::vector<uint32_t> clusters;
+            MeshOptimizer::optimizeVertexCache(indices, vertices.size(), &clusters);
+            MeshOptimizer::optimizeOverdraw(indices, vertices, clusters, importSettings.overdrawThreshold);
+            MeshOptimizer::optimizeVertexFetch(vertices, indices);
+            
+            if (importSettings.verbose) {
+                auto after = MeshOptimizer::analyzeVertexCache(indices, vertices.size());
+                std::cout << "Mesh '" << aiMesh->mName.C_Str() << "': ACMR " << before.acmr << " -> " << after.acmr
+                    << ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+            }
+        }
+        
+        auto lods = generateLods(aiMesh->mName.C_Str(), vertices, indices, importSettings);
+        
+        std::vector<Meshlet> meshlets;
+        if (importSettings.buildMeshlets) {
+            meshlets = MeshOptimizer::buildMeshlets(vertices, indices);
+            if (importSettings.verbose) {
+                std::cout << "Mesh '" << aiMesh->mName.C_Str() << "': " << meshlets.size() << " meshlets" << std::endl;
+            }
+        }
+        
+        meshes.push_back(std::make_shared<Mesh>(device, vertices, indices, meshBoneData, format, lods, meshlets));
     }
     
     return meshes;
 }
 
+std::vector<MeshLod> ModelLoader::generateLods(const std::string& meshName, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const ModelImportSettings& importSettings) {
+    std::vector<MeshLod> lods;
+    if (importSettings.lodCount <= 1 || indices.empty()) {
+        return lods;
+    }
+    
+    glm::vec3 minPosition(std::numeric_limits<float>::max());
+    glm::vec3 maxPosition(std::numeric_limits<float>::lowest());
+    for (const auto& vertex : vertices) {
+        minPosition = glm::min(minPosition, vertex.pos);
+        maxPosition = glm::max(maxPosition, vertex.pos);
+    }
+    auto maxError = glm::length(maxPosition - minPosition) * 0.5f * importSettings.lodMaxError;
+    
+    // Each LOD is simplified from the previous one, so their errors add up
+    auto previousIndices = &indices;
+    float error = 0.0f;
+    
+    for (uint32_t lod = 1; lod < importSettings.lodCount; lod++) {
+        auto targetIndexCount = static_cast<size_t>(previousIndices->size() / 3 * importSettings.lodTriangleRatio) * 3;
+        
+        float stepError;
+        auto lodIndices = MeshOptimizer::simplify(vertices, *previousIndices, targetIndexCount, maxError, &stepError);
+        if (lodIndices.empty() || lodIndices.size() > previousIndices->size() * 9 / 10) {
+            break;
+        }
+        
+        if (importSettings.optimizeIndices) {
+            MeshOptimizer::optimizeVertexCache(lodIndices, vertices.size());
+        }
+        
+        error += stepError;
+        if (importSettings.verbose) {
+            std::cout << "Mesh '" << meshName << "': LOD " << lod << " has " << lodIndices.size() / 3 << " triangles, error "
+                << error << std::endl;
+        }
+        
+        lods.push_back({ std::move(lodIndices), error });
+        previousIndices = &lods.back().indices;
+    }
+    
+    return lods;
+}
+
 void ModelLoader::processMeshNodes(aiNode* node, const aiScene *scene, std::vector<aiMesh*>& meshes) {
     // process all the node's meshes (if any)
     for (uint32_t i = 0; i < node->mNumMeshes; i++) {
@@ -117,7 +207,7 @@ void ModelLoader::processMeshNodes(aiNode* node, const aiScene *scene, std::vect
     }
 }
 
-std::unordered_map<std::string, MeshBoneData> ModelLoader::loadMeshBoneData(aiMesh* mesh, std::vector<Vertex>& vertices) {
+std::unordered_map<std::string, MeshBoneData> ModelLoader::loadMeshBoneData(aiMesh* mesh, std::vector<Vertex>& vertices, std::unordered_map<std::string, MeshBoneData>& modelBoneData) {
     std::unordered_map<std::string, MeshBoneData> bones;
     
     // Key: vertex index, value: number of bone weights
@@ -127,7 +217,12 @@ std::unordered_map<std::string, MeshBoneData> ModelLoader::loadMeshBoneData(aiMe
         auto bone = mesh->mBones[j];
         
         std::string boneName(bone->mName.C_Str());
-        bones[boneName] = MeshBoneData(boneName, j, convertMatrix(bone->mOffsetMatrix));
+        if (modelBoneData.count(boneName) == 0) {
+            auto index = static_cast<uint32_t>(modelBoneData.size());
+            modelBoneData[boneName] = MeshBoneData(boneName, index, convertMatrix(bone->mOffsetMatrix));
+        }
+        auto boneIndex = modelBoneData[boneName].index;
+        bones[boneName] = modelBoneData[boneName];
         
         for (uint32_t k = 0; k < bone->mNumWeights; k++) {
             auto weight = bone->mWeights[k];
@@ -140,7 +235,7 @@ std::unordered_map<std::string, MeshBoneData> ModelLoader::loadMeshBoneData(aiMe
             }
             
             vertices[weight.mVertexId].boneWeights[weightIndex] = weight.mWeight;
-            vertices[weight.mVertexId].boneIds[weightIndex] = j;
+            vertices[weight.mVertexId].boneIds[weightIndex] = boneIndex;
             
             boneWeightsPerVertex[weight.mVertexId] = ++weightIndex;
         }
@@ -149,10 +244,10 @@ std::unordered_map<std::string, MeshBoneData> ModelLoader::loadMeshBoneData(aiMe
     return bones;
 }
 
-std::unique_ptr<Skeleton> ModelLoader::loadSkeleton(const aiScene* scene, std::string& rootName) {
+std::shared_ptr<const Skeleton> ModelLoader::loadSkeleton(const aiScene* scene, std::string& rootName, const std::unordered_map<std::string, MeshBoneData>& modelBoneData) {
     aiNode* root = rootName != "" ? findRootNode(rootName, scene->mRootNode) : scene->mRootNode;
     auto rootBone = processBoneNodes(root, nullptr);
-    return std::make_unique<Skeleton>(rootBone);
+    return std::make_shared<const Skeleton>(rootBone, modelBoneData);
 }
 
 std::shared_ptr<Bone> ModelLoader::processBoneNodes(aiNode* node, std::shared_ptr<Bone> parent) {
@@ -180,8 +275,8 @@ aiNode* ModelLoader::findRootNode(std::string rootName, aiNode* node) {
     return nullptr;
 }
 
-std::unordered_map<std::string, Animation> ModelLoader::loadAnimations(const aiScene* scene) {
-    std::unordered_map<std::string, Animation> animations;
+std::shared_ptr<const AnimationClips> ModelLoader::loadAnimations(const aiScene* scene, const ModelImportSettings& importSettings) {
+    auto animations = std::make_shared<AnimationClips>();
     
     for (uint32_t i = 0; i < scene->mNumAnimations; i++) {
         auto aiAnimation = scene->mAnimations[i];
@@ -209,7 +304,18 @@ std::unordered_map<std::string, Animation> ModelLoader::loadAnimations(const aiS
             }
         }
         
-        animations.emplace(animation.getName(), animation);
+        if (!importSettings.compressAnimations) {
+            (*animations)[animation.getName()] = std::make_shared<const Animation>(std::move(animation));
+            continue;
+        }
+        
+        auto compressed = CompressedAnimation::compress(animation);
+        if (importSettings.verbose) {
+            std::cout << "Compressed animation '" << animation.getName() << "': "
+                << animation.getMemorySize() << " -> " << compressed->getMemorySize() << " bytes, "
+                << compressed->getCompressedKeyCount() << "/" << animation.getKeyCount() << " keys kept" << std::endl;
+        }
+        (*animations)[animation.getName()] = compressed;
     }
     
     return animations;
@@ -10,17 +10,33 @@
 #include "VulkanDevice.hpp"
 #include "Pipeline.hpp"
 #include "PipelineSettings.hpp"
+#include "CompressedAnimation.hpp"
+#include "MeshOptimizer.hpp"
+
+struct ModelImportSettings {
+    bool compressAnimations = true;
+    bool weldVertices = true;
+    float weldEpsilon = 0.0f; // Attributes closer than this are merged, 0 only merges exact duplicates
+    bool optimizeIndices = true; // Vertex cache, overdraw and vertex fetch order
+    float overdrawThreshold = 1.05f; // Highest ACMR increase accepted for a better overdraw order
+    uint32_t lodCount = 4; // Including the full mesh, the chain ends early once simplification stops making progress
+    float lodTriangleRatio = 0.5f; // Triangle count of every LOD relative to the previous one
+    float lodMaxError = 0.05f; // Largest deviation a single LOD step may add, relative to the mesh radius
+    bool buildMeshlets = true; // For culling parts of static meshes on the CPU
+    bool verbose = false; // Prints what welding, index optimization, LODs, meshlets and animation compression did
+};
 
 class ModelLoader {
     
 public:
-    static std::shared_ptr<Model> fromFile(std::string path, VulkanDevice& device, std::shared_ptr<PipelineSettings> pipelineSettings, std::shared_ptr<Uniforms<LocalTransform>> uniforms, std::string rootName = "");
+    static std::shared_ptr<Model> fromFile(std::string path, VulkanDevice& device, std::shared_ptr<PipelineSettings> pipelineSettings, std::shared_ptr<Uniforms<LocalTransform>> uniforms, std::string rootName = "", const ModelImportSettings& importSettings = ModelImportSettings());
     
 private:
-    static std::vector<std::shared_ptr<Mesh>> loadMeshes(const aiScene *scene, VulkanDevice& device);
-    static std::unordered_map<std::string, MeshBoneData> loadMeshBoneData(aiMesh* mesh, std::vector<Vertex>& vertices);
-    static std::unique_ptr<Skeleton> loadSkeleton(const aiScene* scene, std::string& rootName);
-    static std::unordered_map<std::string, Animation> loadAnimations(const aiScene* scene);
+    static std::vector<std::shared_ptr<Mesh>> loadMeshes(const aiScene *scene, VulkanDevice& device, VertexFormat format, const ModelImportSettings& importSettings, std::unordered_map<std::string, MeshBoneData>& modelBoneData);
+    static std::vector<MeshLod> generateLods(const std::string& meshName, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const ModelImportSettings& importSettings);
+    static std::unordered_map<std::string, MeshBoneData> loadMeshBoneData(aiMesh* mesh, std::vector<Vertex>& vertices, std::unordered_map<std::string, MeshBoneData>& modelBoneData);
+    static std::shared_ptr<const Skeleton> loadSkeleton(const aiScene* scene, std::string& rootName, const std::unordered_map<std::string, MeshBoneData>& modelBoneData);
+    static std::shared_ptr<const AnimationClips> loadAnimations(const aiScene* scene, const ModelImportSettings& importSettings);
     
     static void processMeshNodes(aiNode* node, const aiScene *scene, std::vector<aiMesh*>& meshes);
     static std::shared_ptr<Bone> processBoneNodes(aiNode* node, std::shared_ptr<Bone> parent);
@@ -5,7 +5,7 @@
 #include "IoUtils.hpp"
 #include "Vertex.hpp"
 
-Pipeline::Pipeline(VulkanRenderPasses& renderPass, VkDescriptorSetLayout descriptorSetLayout, VkExtent2D extent, PipelineSettings& settings, bool shadowPipeline) : renderPass(renderPass) {
+Pipeline::Pipeline(VulkanRenderPasses& renderPass, const std::vector<VkDescriptorSetLayout>& descriptorSetLayouts, uint32_t pushConstantSize, VkExtent2D extent, PipelineSettings& settings, bool shadowPipeline) : renderPass(renderPass) {
     auto vertShaderCode = IoUtils::readFile(shadowPipeline ? settings.shadowVertexShader : settings.vertexShader);
     auto fragShaderCode = IoUtils::readFile(settings.fragmentShader);
     
@@ -29,12 +29,22 @@ Pipeline::Pipeline(VulkanRenderPasses& renderPass, VkDescriptorSetLayout descrip
     VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
     vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
     
-    auto bindingDescription = Vertex::getBindingDescription();
-    auto attributeDescriptions = Vertex::getAttributeDescriptions();
+    std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
     
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
+    if (shadowPipeline) {
+        // Depth-only passes read the separate position (and bone) streams, see Mesh::bindDepthBuffers
+        bindingDescriptions = Vertex::getDepthBindingDescriptions(settings.vertexFormat, settings.skinned);
+        attributeDescriptions = Vertex::getDepthAttributeDescriptions(settings.vertexFormat, settings.skinned);
+    } else {
+        auto interleavedAttributes = Vertex::getAttributeDescriptions(settings.vertexFormat);
+        bindingDescriptions.push_back(Vertex::getBindingDescription(settings.vertexFormat));
+        attributeDescriptions.assign(interleavedAttributes.begin(), interleavedAttributes.end());
+    }
+    
+    vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
     vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+    vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
     vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
     
     VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
@@ -101,8 +111,18 @@ Pipeline::Pipeline(VulkanRenderPasses& renderPass, VkDescriptorSetLayout descrip
     
     VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 1;
-    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+    
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = pushConstantSize;
+    
+    if (pushConstantSize > 0) {
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    }
     
     if (vkCreatePipelineLayout(renderPass.vulkanDevice.device, &pipelineLayoutInfo, nullptr, &layout) != VK_SUCCESS) {
         throw std::runtime_error("failed to create pipeline layout!");
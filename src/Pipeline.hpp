@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include <vulkan/vulkan.h>
 
 #include "VulkanRenderPasses.hpp"
@@ -8,7 +10,7 @@
 class Pipeline {
     
 public:
-    Pipeline(VulkanRenderPasses& renderPass, VkDescriptorSetLayout descriptorSetLayout, VkExtent2D extent, PipelineSettings& settings, bool shadowPipeline);
+    Pipeline(VulkanRenderPasses& renderPass, const std::vector<VkDescriptorSetLayout>& descriptorSetLayouts, uint32_t pushConstantSize, VkExtent2D extent, PipelineSettings& settings, bool shadowPipeline);
     virtual ~Pipeline();
     
     void bind(VkCommandBuffer commandBuffer);
@@ -2,6 +2,8 @@
 
 #include <vulkan/vulkan.h>
 
+#include "Vertex.hpp"
+
 struct PipelineSettings {
     std::string vertexShader;
     std::string shadowVertexShader;
@@ -11,6 +13,8 @@ struct PipelineSettings {
     VkCullModeFlags cullMode;
     VkCompareOp depthCompareOp;
     VkPrimitiveTopology topology;
+    VertexFormat vertexFormat; // Meshes loaded for the pipeline use this format
+    bool skinned; // Whether the shaders deform vertices with the bone palette, the shadow pass then reads the bone stream
 };
 
 class PipelineSettingsBuilder {
@@ -56,6 +60,16 @@ public:
         return *this;
     }
     
+    PipelineSettingsBuilder& vertexFormat(VertexFormat vertexFormat) {
+        m_vertexFormat = vertexFormat;
+        return *this;
+    }
+    
+    PipelineSettingsBuilder& skinned(bool value) {
+        m_skinned = value;
+        return *this;
+    }
+    
     std::shared_ptr<PipelineSettings> build() {
         auto settings = std::make_shared<PipelineSettings>();
         settings->vertexShader = m_vertexShader;
@@ -66,6 +80,8 @@ public:
         settings->cullMode = m_cullMode;
         settings->depthCompareOp = m_depthCompareOp;
         settings->topology = m_topology;
+        settings->vertexFormat = m_vertexFormat;
+        settings->skinned = m_skinned;
         return settings;
     }
     
@@ -78,5 +94,7 @@ private:
     VkCullModeFlags m_cullMode = VK_CULL_MODE_BACK_BIT;
     VkCompareOp m_depthCompareOp = VK_COMPARE_OP_LESS;
     VkPrimitiveTopology m_topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    VertexFormat m_vertexFormat = VertexFormat::Full;
+    bool m_skinned = false;
     
 };
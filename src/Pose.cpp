@@ -0,0 +1,95 @@
+#include "Pose.hpp"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/quaternion.hpp>
+#include <glm/gtx/matrix_decompose.hpp>
+
+#include "Skeleton.hpp"
+
+glm::mat4 JointPose::toMatrix() const {
+    auto translationMatrix = glm::translate(glm::mat4(1.0f), translation);
+    auto rotationMatrix = glm::toMat4(rotation);
+    auto scaleMatrix = glm::scale(glm::mat4(1.0f), scale);
+
+    return translationMatrix * rotationMatrix * scaleMatrix;
+}
+
+JointPose JointPose::fromMatrix(const glm::mat4& matrix) {
+    JointPose pose;
+    glm::vec3 skew;
+    glm::vec4 perspective;
+
+    if (!glm::decompose(matrix, pose.scale, pose.rotation, pose.translation, skew, perspective)) {
+        pose.translation = glm::vec3(matrix[3]);
+        pose.rotation = glm::identity<glm::quat>();
+        pose.scale = glm::vec3(1.0f);
+    }
+    return pose;
+}
+
+void Pose::setBindPose(const Skeleton& skeleton) {
+    auto& skeletonJoints = skeleton.getJoints();
+
+    joints.resize(skeletonJoints.size());
+    for (size_t i = 0; i < skeletonJoints.size(); i++) {
+        joints[i] = skeletonJoints[i].bindPose;
+    }
+}
+
+void Pose::toModelSpace(const Skeleton& skeleton, std::vector<glm::mat4>& globalTransforms, std::vector<glm::mat4>& palette, bool skipDetailJoints) const {
+    auto& skeletonJoints = skeleton.getJoints();
+
+    for (size_t i = 0; i < skeletonJoints.size(); i++) {
+        auto& joint = skeletonJoints[i];
+        auto localTransformation = skipDetailJoints && joint.detail ? joint.transformation : joints[i].toMatrix();
+
+        // Parents always precede their children, so their global transform is already up to date
+        globalTransforms[i] = joint.parent >= 0 ? globalTransforms[joint.parent] * localTransformation : localTransformation;
+
+        if (joint.paletteIndex >= 0) {
+            palette[joint.paletteIndex] = globalTransforms[i] * joint.offset;
+        }
+    }
+}
+
+void Pose::blend(const Pose& from, const Pose& to, float weight, Pose& result) {
+    result.joints.resize(to.joints.size());
+
+    for (size_t i = 0; i < to.joints.size(); i++) {
+        auto& a = from.joints[i];
+        auto& b = to.joints[i];
+        auto& r = result.joints[i];
+
+        r.translation = glm::mix(a.translation, b.translation, weight);
+        r.rotation = glm::slerp(a.rotation, b.rotation, weight);
+        r.scale = glm::mix(a.scale, b.scale, weight);
+    }
+}
+
+void Pose::addAdditive(const Pose& base, const Pose& additive, const Pose& reference, float weight, Pose& result) {
+    result.joints.resize(base.joints.size());
+
+    for (size_t i = 0; i < base.joints.size(); i++) {
+        auto& b = base.joints[i];
+        auto& a = additive.joints[i];
+        auto& ref = reference.joints[i];
+        auto& r = result.joints[i];
+
+        auto deltaRotation = a.rotation * glm::inverse(ref.rotation);
+
+        r.translation = b.translation + (a.translation - ref.translation) * weight;
+        r.rotation = glm::normalize(glm::slerp(glm::identity<glm::quat>(), deltaRotation, weight) * b.rotation);
+        r.scale = b.scale * glm::mix(glm::vec3(1.0f), a.scale / ref.scale, weight);
+    }
+}
+
+Pose& PosePool::acquire(size_t jointCount) {
+    if (used == poses.size()) {
+        poses.push_back(std::make_unique<Pose>());
+    }
+
+    auto& pose = *poses[used++];
+    pose.joints.resize(jointCount);
+    return pose;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+class Skeleton;
+
+struct JointPose {
+    glm::vec3 translation;
+    glm::quat rotation;
+    glm::vec3 scale;
+
+    glm::mat4 toMatrix() const;
+    static JointPose fromMatrix(const glm::mat4& matrix);
+};
+
+/** Local-space transforms for every joint of a skeleton. Blending happens on poses, matrices are only built at the end. */
+class Pose {
+
+public:
+    std::vector<JointPose> joints;
+
+    void setBindPose(const Skeleton& skeleton);
+    /** Builds global transforms and the bone palette, skipped detail joints reuse their bind matrix instead of composing one */
+    void toModelSpace(const Skeleton& skeleton, std::vector<glm::mat4>& globalTransforms, std::vector<glm::mat4>& palette, bool skipDetailJoints = false) const;
+
+    /** Interpolates from one pose to the other, result may alias either input */
+    static void blend(const Pose& from, const Pose& to, float weight, Pose& result);
+
+    /** Applies the difference between additive and reference on top of base, result may alias base */
+    static void addAdditive(const Pose& base, const Pose& additive, const Pose& reference, float weight, Pose& result);
+
+};
+
+/**
+ * Frame-scoped pose buffers. Poses acquired from the pool stay valid until the next reset().
+ * Buffers keep their capacity between frames, so blending doesn't allocate once the pool has warmed up.
+ */
+class PosePool {
+
+public:
+    Pose& acquire(size_t jointCount);
+    void reset() { used = 0; }
+
+    size_t getPoseCount() const { return poses.size(); }
+
+private:
+    std::vector<std::unique_ptr<Pose>> poses;
+    size_t used = 0;
+
+};
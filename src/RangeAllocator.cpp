@@ -0,0 +1,78 @@
+#include "RangeAllocator.hpp"
+
+#include <stdexcept>
+#include <iterator>
+
+RangeAllocator::RangeAllocator(uint64_t capacity) : capacity(capacity) {
+    if (capacity > 0) {
+        freeRanges[0] = capacity;
+    }
+}
+
+uint64_t RangeAllocator::allocate(uint64_t size, uint64_t alignment) {
+    if (size == 0) {
+        throw std::runtime_error("Can't allocate an empty range.");
+    }
+
+    for (auto it = freeRanges.begin(); it != freeRanges.end(); it++) {
+        auto rangeOffset = it->first;
+        auto rangeSize = it->second;
+
+        auto offset = (rangeOffset + alignment - 1) / alignment * alignment;
+        auto padding = offset - rangeOffset;
+        if (padding + size > rangeSize) {
+            continue;
+        }
+
+        // Keep the alignment padding in front and the rest behind the allocation free
+        freeRanges.erase(it);
+        if (padding > 0) {
+            freeRanges[rangeOffset] = padding;
+        }
+        if (padding + size < rangeSize) {
+            freeRanges[offset + size] = rangeSize - padding - size;
+        }
+
+        usedSize += size;
+        return offset;
+    }
+
+    return INVALID_OFFSET;
+}
+
+void RangeAllocator::free(uint64_t offset, uint64_t size) {
+    auto next = freeRanges.lower_bound(offset);
+    if (next != freeRanges.end() && next->first < offset + size) {
+        throw std::runtime_error("Range is already free.");
+    }
+
+    auto previous = next != freeRanges.begin() ? std::prev(next) : freeRanges.end();
+    if (previous != freeRanges.end() && previous->first + previous->second > offset) {
+        throw std::runtime_error("Range is already free.");
+    }
+    usedSize -= size;
+
+    // Merge with the free ranges directly before and after
+    if (previous != freeRanges.end() && previous->first + previous->second == offset) {
+        offset = previous->first;
+        size += previous->second;
+        freeRanges.erase(previous);
+    }
+    if (next != freeRanges.end() && next->first == offset + size) {
+        size += next->second;
+        freeRanges.erase(next);
+    }
+
+    freeRanges[offset] = size;
+}
+
+void RangeAllocator::grow(uint64_t newCapacity) {
+    if (newCapacity <= capacity) {
+        return;
+    }
+
+    auto addedSize = newCapacity - capacity;
+    usedSize += addedSize; // free() subtracts it again
+    free(capacity, addedSize);
+    capacity = newCapacity;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <map>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * First-fit free-list allocator over the abstract range [0, capacity), for sub-allocating large buffers.
+ * Freed ranges are merged with their free neighbours, so the list stays short.
+ */
+class RangeAllocator {
+
+public:
+    static const uint64_t INVALID_OFFSET = UINT64_MAX;
+
+    explicit RangeAllocator(uint64_t capacity = 0);
+
+    /** Returns INVALID_OFFSET if no free range is large enough */
+    uint64_t allocate(uint64_t size, uint64_t alignment = 1);
+    void free(uint64_t offset, uint64_t size);
+
+    /** Adds free space at the end, existing allocations keep their offsets */
+    void grow(uint64_t newCapacity);
+
+    uint64_t getCapacity() const { return capacity; }
+    uint64_t getUsedSize() const { return usedSize; }
+    size_t getFreeRangeCount() const { return freeRanges.size(); }
+
+private:
+    std::map<uint64_t, uint64_t> freeRanges; // Offset -> size
+    uint64_t capacity;
+    uint64_t usedSize = 0;
+
+};
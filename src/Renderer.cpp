@@ -1,5 +1,8 @@
 #include "Renderer.hpp"
 
+#include "UploadQueue.hpp"
+#include "BindlessResources.hpp"
+
 Renderer::Renderer(GLFWwindow* window) {
     this->window = window;
     initVulkan();
@@ -11,6 +14,8 @@ Renderer::~Renderer() {
 
 void Renderer::initVulkan() {
     vulkanDevice = std::make_unique<VulkanDevice>(window);
+    frameDescriptors = std::make_unique<FrameDescriptors>(*vulkanDevice);
+    descriptorAllocator = std::make_unique<DescriptorAllocator>(vulkanDevice->device);
     
     createFramebuffers();
 }
@@ -33,9 +38,9 @@ void Renderer::cleanupSwapChain() {
     
     swapChain.reset();
     
-    for (auto& model : models) {
-        model->getUniforms().destroyDescriptors();
-    }
+    // Releases the descriptor sets of all models at once
+    descriptorAllocator->reset();
+    uniformRing.reset();
 }
 
 void Renderer::cleanup() {
@@ -44,6 +49,8 @@ void Renderer::cleanup() {
     for (auto& model : models) {
         model.reset();
     }
+    frameDescriptors.reset();
+    descriptorAllocator.reset();
     
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
         vkDestroySemaphore(vulkanDevice->device, renderFinishedSemaphores[i], nullptr);
@@ -75,20 +82,25 @@ void Renderer::createFramebuffers() {
     swapChain = std::make_unique<VulkanSwapchain>(*vulkanDevice);
     renderPass = std::make_unique<VulkanRenderPasses>(*vulkanDevice, swapChain->imageFormat, swapChain->depthFormat);
     framebuffer = std::make_unique<VulkanFramebuffer>(*vulkanDevice, *renderPass, *swapChain, swapChain->extent);
+    uniformRing = std::make_unique<UniformRing>(*vulkanDevice, static_cast<uint32_t>(swapChain->imageNumber()));
+    frameDescriptors->initializeDescriptors(*descriptorAllocator, *uniformRing);
 }
 
 void Renderer::createModelPipelines() {
     for (auto& model : models) {
-        auto mainPipeline = std::make_shared<Pipeline>(*renderPass, model->getUniforms().getDescriptorSetLayout(), swapChain->extent, model->getPipelineSettings(), false);
+        std::vector<VkDescriptorSetLayout> setLayouts = {frameDescriptors->getDescriptorSetLayout(), model->getUniforms().getDescriptorSetLayout()};
+        if (vulkanDevice->bindlessResources) {
+            setLayouts.push_back(vulkanDevice->bindlessResources->getDescriptorSetLayout());
+        }
+        auto mainPipeline = std::make_shared<Pipeline>(*renderPass, setLayouts, sizeof(LocalTransform), swapChain->extent, model->getPipelineSettings(), false);
         
         model->setPipeline(mainPipeline);
-        model->getUniforms().initializeDescriptors(*swapChain, *framebuffer);
+        model->getUniforms().initializeDescriptors(*descriptorAllocator, *uniformRing, *framebuffer);
         
         if (model->getPipelineSettings().shadowVertexShader != "") {
             // Shadows are disabled if no shadow vertex shader is set
-            auto shadowPipeline = std::make_shared<Pipeline>(*renderPass, model->getUniforms().getDescriptorSetLayout(), VkExtent2D {VulkanFramebuffer::SHADOWMAP_SIZE, VulkanFramebuffer::SHADOWMAP_SIZE}, model->getPipelineSettings(), true);
+            auto shadowPipeline = std::make_shared<Pipeline>(*renderPass, setLayouts, sizeof(LocalTransform), VkExtent2D {VulkanFramebuffer::SHADOWMAP_SIZE, VulkanFramebuffer::SHADOWMAP_SIZE}, model->getPipelineSettings(), true);
             model->setShadowPipeline(shadowPipeline);
-            model->getUniforms().initializeDescriptors(*swapChain, *framebuffer);
         }
     }
 }
@@ -106,81 +118,192 @@ void Renderer::createCommandBuffers() {
         throw std::runtime_error("failed to allocate command buffers!");
     }
     
+    imagesInFlight.assign(commandBuffers.size(), VK_NULL_HANDLE);
+}
+
+void Renderer::recordCommandBuffer(uint32_t imageIndex) {
+    // Recorded every frame, so per-frame decisions like the mesh LODs end up in the draw calls
+    auto commandBuffer = commandBuffers[imageIndex];
+    vkResetCommandBuffer(commandBuffer, 0);
+    
+    // LODs are picked once per mesh, so the shadow pass draws the same geometry as the main pass
+    std::vector<std::vector<uint32_t>> meshLods(models.size());
+    for (size_t m = 0; m < models.size(); m++) {
+        for (auto& mesh : models[m]->getMeshes()) {
+            auto lod = meshLodSettings.forcedLod >= 0 ? static_cast<uint32_t>(meshLodSettings.forcedLod)
+                : mesh->selectLod(modelPixelsPerUnit[m], meshLodSettings.maxPixelError);
+            meshLods[m].push_back(lod);
+        }
+    }
+    
+    std::vector<std::vector<uint8_t>> meshVisibility;
+    cullMeshes(meshVisibility);
+    
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording command buffer!");
+    }
+    
+    // 1. Shadow Map Render Pass
+    
     std::array<VkClearValue, 2> clearValues = {};
-    for (size_t i = 0; i < commandBuffers.size(); i++) {
-        VkCommandBufferBeginInfo beginInfo = {};
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-        
-        if (vkBeginCommandBuffer(commandBuffers[i], &beginInfo) != VK_SUCCESS) {
-            throw std::runtime_error("failed to begin recording command buffer!");
+    VkRenderPassBeginInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = renderPass->shadowsRenderPass;
+    renderPassInfo.framebuffer = framebuffer->shadowFramebuffer;
+    renderPassInfo.renderArea.offset = {0, 0};
+    renderPassInfo.renderArea.extent = {VulkanFramebuffer::SHADOWMAP_SIZE, VulkanFramebuffer::SHADOWMAP_SIZE};
+    
+    clearValues[0].depthStencil = {1.0f, 0};
+    
+    renderPassInfo.clearValueCount = 1;
+    renderPassInfo.pClearValues = clearValues.data();
+    
+    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    
+    // Meshes share their arena's buffers, so bindings only change with the vertex format or index type
+    const void* boundKey = nullptr;
+    VkIndexType boundIndexType = VK_INDEX_TYPE_UINT32;
+    // All pipeline layouts share set 0, so the globals stay bound across pipelines and both passes
+    bool frameSetBound = false;
+    
+    for (size_t m = 0; m < models.size(); m++) {
+        auto& model = models[m];
+        if (!model->hasShadows()) {
+            continue;
         }
         
-        // 1. Shadow Map Render Pass
-        
-        VkRenderPassBeginInfo renderPassInfo = {};
-        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassInfo.renderPass = renderPass->shadowsRenderPass;
-        renderPassInfo.framebuffer = framebuffer->shadowFramebuffer;
-        renderPassInfo.renderArea.offset = {0, 0};
-        renderPassInfo.renderArea.extent = {VulkanFramebuffer::SHADOWMAP_SIZE, VulkanFramebuffer::SHADOWMAP_SIZE};
-        
-        clearValues[0].depthStencil = {1.0f, 0};
+        model->getShadowPipeline().bind(commandBuffer);
+        if (!frameSetBound) {
+            frameDescriptors->bind(commandBuffer, model->getShadowPipeline());
+            frameSetBound = true;
+        }
+        model->getUniforms().bind(commandBuffer, model->getShadowPipeline());
         
-        renderPassInfo.clearValueCount = 1;
-        renderPassInfo.pClearValues = clearValues.data();
+        auto& meshes = model->getMeshes();
+        for (size_t j = 0; j < meshes.size(); j++) {
+            if (meshes[j]->getBindingKey() != boundKey || meshes[j]->getIndexType() != boundIndexType) {
+                meshes[j]->bindDepthBuffers(commandBuffer);
+                boundKey = meshes[j]->getBindingKey();
+                boundIndexType = meshes[j]->getIndexType();
+            }
+            meshes[j]->draw(commandBuffer, meshLods[m][j]);
+        }
+    }
+    
+    vkCmdEndRenderPass(commandBuffer);
+    
+    // 2. Main Render Pass
+    
+    renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = renderPass->mainRenderPass;
+    renderPassInfo.framebuffer = framebuffer->swapChainFramebuffers[imageIndex];
+    renderPassInfo.renderArea.offset = {0, 0};
+    renderPassInfo.renderArea.extent = swapChain->extent;
+    
+    clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
+    clearValues[1].depthStencil = {1.0f, 0};
+    
+    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+    renderPassInfo.pClearValues = clearValues.data();
+    
+    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    
+    meshletStats = {};
+    boundKey = nullptr;
+    // Binding set 1 with a different layout disturbs set 2, models with the same cached layout keep the bindless set
+    VkDescriptorSetLayout bindlessBoundWith = VK_NULL_HANDLE;
+    
+    for (size_t m = 0; m < models.size(); m++) {
+        auto& model = models[m];
+        model->getPipeline().bind(commandBuffer);
+        if (!frameSetBound) {
+            frameDescriptors->bind(commandBuffer, model->getPipeline());
+            frameSetBound = true;
+        }
+        model->getUniforms().bind(commandBuffer, model->getPipeline());
+        if (vulkanDevice->bindlessResources && model->getUniforms().getDescriptorSetLayout() != bindlessBoundWith) {
+            vulkanDevice->bindlessResources->bind(commandBuffer, model->getPipeline());
+            bindlessBoundWith = model->getUniforms().getDescriptorSetLayout();
+        }
         
-        vkCmdBeginRenderPass(commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        // Meshlets are culled in model space, against the matrices updateUniforms just wrote
+        auto& modelMatrix = model->getUniforms().ubo.model;
+        auto frustum = Frustum::fromMatrix(globals.proj * globals.view * modelMatrix);
+        auto cameraPosition = glm::vec3(glm::inverse(globals.view * modelMatrix)[3]);
         
-        for (auto& model : models) {
-            if (!model->hasShadows()) {
+        auto& meshes = model->getMeshes();
+        for (size_t j = 0; j < meshes.size(); j++) {
+            if (!meshVisibility[m][j]) {
                 continue;
             }
             
-            model->getShadowPipeline().bind(commandBuffers[i]);
-            model->getUniforms().bind(commandBuffers[i], model->getShadowPipeline(), i);
-            
-            for (auto& mesh : model->getMeshes()) {
-                mesh->bindBuffers(commandBuffers[i]);
-                mesh->draw(commandBuffers[i]);
+            if (meshes[j]->getBindingKey() != boundKey || meshes[j]->getIndexType() != boundIndexType) {
+                meshes[j]->bindBuffers(commandBuffer);
+                boundKey = meshes[j]->getBindingKey();
+                boundIndexType = meshes[j]->getIndexType();
             }
-        }
-        
-        vkCmdEndRenderPass(commandBuffers[i]);
-        
-        // 2. Main Render Pass
-        
-        renderPassInfo = {};
-        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassInfo.renderPass = renderPass->mainRenderPass;
-        renderPassInfo.framebuffer = framebuffer->swapChainFramebuffers[i];
-        renderPassInfo.renderArea.offset = {0, 0};
-        renderPassInfo.renderArea.extent = swapChain->extent;
-        
-        clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
-        clearValues[1].depthStencil = {1.0f, 0};
-        
-        renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-        renderPassInfo.pClearValues = clearValues.data();
-        
-        vkCmdBeginRenderPass(commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-        
-        for (auto& model : models) {
-            model->getPipeline().bind(commandBuffers[i]);
-            model->getUniforms().bind(commandBuffers[i], model->getPipeline(), i);
             
-            for (auto& mesh : model->getMeshes()) {
-                mesh->bindBuffers(commandBuffers[i]);
-                mesh->draw(commandBuffers[i]);
+            // Meshlet bounds are only valid for meshes the shaders don't deform and coarser LODs have none. A bone
+            // stream alone doesn't matter, static pipelines ignore it. The cone test assumes back faces are culled.
+            auto& settings = model->getPipelineSettings();
+            if (meshletCulling && meshLods[m][j] == 0 && meshes[j]->hasMeshlets() && !settings.skinned
+                    && settings.cullMode == VK_CULL_MODE_BACK_BIT) {
+                meshes[j]->cullMeshlets(frustum, cameraPosition, visibleRanges, meshletStats);
+                meshes[j]->drawRanges(commandBuffer, visibleRanges);
+            } else {
+                meshes[j]->draw(commandBuffer, meshLods[m][j]);
             }
         }
+    }
+    
+    vkCmdEndRenderPass(commandBuffer);
+    
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record command buffer!");
+    }
+}
+
+void Renderer::cullMeshes(std::vector<std::vector<uint8_t>>& meshVisibility) {
+    cullingStats = {};
+    cullingBoxes.clear();
+    culledMeshIndices.clear();
+    
+    // Everything is visible unless tested, the shadow pass ignores this since off-screen meshes can cast into view
+    meshVisibility.resize(models.size());
+    for (size_t m = 0; m < models.size(); m++) {
+        auto& model = models[m];
+        auto& meshes = model->getMeshes();
+        meshVisibility[m].assign(meshes.size(), 1);
         
-        vkCmdEndRenderPass(commandBuffers[i]);
-        
-        if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS) {
-            throw std::runtime_error("failed to record command buffer!");
+        auto& modelMatrix = model->getUniforms().ubo.model;
+        // Mesh bounds follow CPU-side vertex changes, but skinning shaders move vertices away from the bind pose
+        auto margin = model->getPipelineSettings().skinned ? FrustumCulling::SKINNED_BOUNDS_MARGIN : 0.0f;
+        for (size_t j = 0; j < meshes.size(); j++) {
+            if (!frustumCulling || !model->frustumCulling) {
+                cullingStats.untestedMeshes++;
+                continue;
+            }
+            
+            glm::vec3 center, extent;
+            FrustumCulling::transformBox(meshes[j]->getBounds(), modelMatrix, center, extent, margin);
+            cullingBoxes.add(center, extent);
+            culledMeshIndices.emplace_back(m, j);
         }
     }
+    
+    auto frustum = Frustum::fromMatrix(globals.proj * globals.view);
+    FrustumCulling::cullBoxes(frustum, cullingBoxes, boxVisibility);
+    
+    for (size_t i = 0; i < culledMeshIndices.size(); i++) {
+        meshVisibility[culledMeshIndices[i].first][culledMeshIndices[i].second] = boxVisibility[i];
+        cullingStats.visibleMeshes += boxVisibility[i];
+    }
+    cullingStats.testedMeshes = static_cast<uint32_t>(culledMeshIndices.size());
 }
 
 void Renderer::createSyncObjects() {
@@ -213,18 +336,76 @@ void Renderer::updateUniforms(uint32_t currentImage) {
     auto projectionMatrix = glm::perspective(glm::radians(camera.fovy), camera.aspectRatio, camera.nearPlane, camera.farPlane);
     projectionMatrix[1][1] *= -1;
 
-    for (auto& model : models) {
+    // Poses are only needed until the palettes are built
+    posePool.reset();
+    animationStats = {};
+    frameIndex++;
+
+    auto cameraPosition = glm::vec3(glm::inverse(viewMatrix)[3]);
+    auto pixelsPerUnitAtOne = swapChain->extent.height / (2.0f * std::tan(glm::radians(camera.fovy) * 0.5f));
+    modelPixelsPerUnit.resize(models.size());
+    globals.view = viewMatrix;
+    globals.proj = projectionMatrix;
+    uniformRing->beginFrame(currentImage);
+    frameDescriptors->update(*uniformRing, globals);
+
+    for (size_t i = 0; i < models.size(); i++) {
+        auto& model = models[i];
+
         auto modelMatrix = glm::scale(glm::mat4(1.0f), model->scale);
         modelMatrix *= glm::toMat4(model->rotation);
         modelMatrix = glm::translate(modelMatrix, model->position);
 
         model->getUniforms().ubo.model = modelMatrix;
-        model->getUniforms().ubo.view = viewMatrix;
-        model->getUniforms().ubo.proj = projectionMatrix;
-        model->getUniforms().update(currentImage, globals);
+        
+        auto distance = glm::length(glm::vec3(modelMatrix[3]) - cameraPosition);
+        auto scale = std::max(model->scale.x, std::max(model->scale.y, model->scale.z));
+        modelPixelsPerUnit[i] = pixelsPerUnitAtOne * scale / std::max(distance, camera.nearPlane);
+
+        if (model->hasAnimationState()) {
+            updateAnimation(*model, i, modelMatrix, cameraPosition);
+        }
+
+        model->getUniforms().update(*uniformRing);
     }
 }
 
+void Renderer::updateAnimation(Model& model, size_t modelIndex, const glm::mat4& modelMatrix, glm::vec3 cameraPosition) {
+    auto& state = model.getAnimationState();
+    auto distance = glm::length(glm::vec3(modelMatrix[3]) - cameraPosition);
+
+    uint32_t updateInterval = 1;
+    for (const auto& level : animationLodSettings.levels) {
+        if (distance >= level.distance) {
+            updateInterval = level.updateInterval;
+        }
+    }
+
+    // Offsetting by the model index staggers reduced-rate instances, so they don't all update on the same frame
+    if (updateInterval > 1 && (frameIndex + modelIndex) % updateInterval != 0) {
+        animationStats.skippedInstances++;
+        return;
+    }
+
+    auto& skeleton = state.getSkeleton();
+    auto radius = skeleton.getBindRadius() * std::max(model.scale.x, std::max(model.scale.y, model.scale.z));
+    auto screenSize = radius / (std::max(distance, camera.nearPlane) * std::tan(glm::radians(camera.fovy) * 0.5f));
+    auto skipDetailJoints = screenSize < animationLodSettings.detailJointScreenSize;
+    state.setSkipDetailJoints(skipDetailJoints);
+
+    auto evaluatedJoints = state.update(posePool);
+    animationStats.updatedInstances++;
+    animationStats.evaluatedJoints += evaluatedJoints;
+    if (evaluatedJoints > 0 && skipDetailJoints) {
+        animationStats.skippedJoints += static_cast<uint32_t>(skeleton.getDetailJointCount());
+    }
+
+    auto& palette = state.getPalette();
+    auto& boneTransforms = model.getUniforms().boneTransforms;
+    auto boneCount = std::min(palette.size(), boneTransforms.size());
+    std::copy(palette.begin(), palette.begin() + boneCount, boneTransforms.begin());
+}
+
 void Renderer::drawFrame() {
     vkWaitForFences(vulkanDevice->device, 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
     
@@ -239,7 +420,17 @@ void Renderer::drawFrame() {
         throw std::runtime_error("failed to acquire swap chain image!");
     }
     
+    // The image may still be in use by an older frame than the one just waited for
+    if (imagesInFlight[imageIndex] != VK_NULL_HANDLE) {
+        vkWaitForFences(vulkanDevice->device, 1, &imagesInFlight[imageIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+    }
+    imagesInFlight[imageIndex] = inFlightFences[currentFrame];
+    
     updateUniforms(imageIndex);
+    recordCommandBuffer(imageIndex);
+    
+    // Transfers recorded since the last frame (e.g. for meshes created in between) have to run first
+    vulkanDevice->uploadQueue->submit();
     
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -19,10 +19,16 @@
 #include "VulkanSwapchain.hpp"
 #include "VulkanRenderPasses.hpp"
 #include "VulkanFramebuffer.hpp"
+#include "UniformRing.hpp"
+#include "FrameDescriptors.hpp"
+#include "DescriptorAllocator.hpp"
 #include "Model.hpp"
 #include "Light.hpp"
 #include "Camera.hpp"
+#include "AnimationLod.hpp"
 #include "Globals.hpp"
+#include "Pose.hpp"
+#include "FrustumCulling.hpp"
 
 const int WIDTH = 800;
 const int HEIGHT = 600;
@@ -41,6 +47,13 @@ public:
     
     Camera& getCamera() { return camera; }
     Globals& getGlobals() { return globals; }
+    AnimationLodSettings& getAnimationLodSettings() { return animationLodSettings; }
+    MeshLodSettings& getMeshLodSettings() { return meshLodSettings; }
+    const MeshletStats& getMeshletStats() const { return meshletStats; }
+    void setMeshletCulling(bool enabled) { meshletCulling = enabled; }
+    const CullingStats& getCullingStats() const { return cullingStats; }
+    void setFrustumCulling(bool enabled) { frustumCulling = enabled; }
+    const AnimationStats& getAnimationStats() const { return animationStats; }
     VulkanDevice& getDevice() { return *vulkanDevice; }
 
     void addModel(std::shared_ptr<Model>& model) { models.push_back(model); }
@@ -60,6 +73,9 @@ private:
     std::unique_ptr<VulkanSwapchain> swapChain = nullptr;
     std::unique_ptr<VulkanRenderPasses> renderPass = nullptr;
     std::unique_ptr<VulkanFramebuffer> framebuffer = nullptr;
+    std::unique_ptr<UniformRing> uniformRing = nullptr; // Per-frame uniform data of all models
+    std::unique_ptr<FrameDescriptors> frameDescriptors = nullptr; // Globals, bound once as set 0 of every pass
+    std::unique_ptr<DescriptorAllocator> descriptorAllocator = nullptr; // Sets pointing at swap chain resources
     std::vector<std::shared_ptr<Model>> models;
     
     std::vector<VkCommandBuffer> commandBuffers;
@@ -67,9 +83,24 @@ private:
     std::vector<VkSemaphore> imageAvailableSemaphores;
     std::vector<VkSemaphore> renderFinishedSemaphores;
     std::vector<VkFence> inFlightFences;
+    std::vector<VkFence> imagesInFlight; // Fence of the frame last rendering to each swapchain image
     Camera camera;
     Globals globals;
+    PosePool posePool;
+    AnimationLodSettings animationLodSettings;
+    AnimationStats animationStats = {};
+    MeshLodSettings meshLodSettings;
+    std::vector<float> modelPixelsPerUnit; // Screen pixels covered by one model unit at each model's distance
+    bool meshletCulling = true;
+    MeshletStats meshletStats = {};
+    std::vector<IndexRange> visibleRanges;
+    bool frustumCulling = true;
+    CullingStats cullingStats = {};
+    CullingBoxes cullingBoxes; // World space bounds of the meshes tested this frame
+    std::vector<std::pair<size_t, size_t>> culledMeshIndices; // Model and mesh index of each tested box
+    std::vector<uint8_t> boxVisibility;
     size_t currentFrame = 0;
+    uint64_t frameIndex = 0;
     
     bool framebufferResized = false;
     
@@ -79,7 +110,10 @@ private:
     void createFramebuffers();
     void createModelPipelines();
     void createCommandBuffers();
+    void recordCommandBuffer(uint32_t imageIndex);
+    void cullMeshes(std::vector<std::vector<uint8_t>>& meshVisibility);
     void createSyncObjects();
     void updateUniforms(uint32_t currentImage);
+    void updateAnimation(Model& model, size_t modelIndex, const glm::mat4& modelMatrix, glm::vec3 cameraPosition);
     
 };
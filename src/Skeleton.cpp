@@ -0,0 +1,84 @@
+#include "Skeleton.hpp"
+
+Skeleton::Skeleton(std::shared_ptr<Bone> root, const std::unordered_map<std::string, MeshBoneData>& boneData)
+        : paletteSize(0), detailJointCount(0), bindRadius(0.0f) {
+    for (const auto& entry : boneData) {
+        paletteSize = std::max(paletteSize, static_cast<size_t>(entry.second.index) + 1);
+    }
+
+    if (root != nullptr) {
+        addJoints(root, -1, boneData);
+        markDetailJoints();
+    }
+}
+
+void Skeleton::addJoints(const std::shared_ptr<Bone>& bone, int32_t parent, const std::unordered_map<std::string, MeshBoneData>& boneData) {
+    Joint joint = {};
+    joint.name = bone->name;
+    joint.parent = parent;
+    joint.transformation = bone->transformation;
+    joint.bindPose = JointPose::fromMatrix(bone->transformation);
+    joint.paletteIndex = -1;
+    joint.offset = glm::mat4(1.0f);
+    joint.detail = false;
+
+    auto it = boneData.find(bone->name);
+    if (it != boneData.end()) {
+        joint.paletteIndex = static_cast<int32_t>(it->second.index);
+        joint.offset = it->second.offset;
+    }
+
+    auto index = static_cast<int32_t>(joints.size());
+    joints.push_back(joint);
+    jointIndices[bone->name] = index;
+
+    for (const auto& child : bone->children) {
+        addJoints(child, index, boneData);
+    }
+}
+
+void Skeleton::markDetailJoints() {
+    // Joints whose whole subtree spans less than this fraction of the skeleton are only visible up close
+    const float detailFraction = 0.1f;
+
+    std::vector<glm::vec3> positions(joints.size());
+    std::vector<glm::mat4> globalTransforms(joints.size());
+    for (size_t i = 0; i < joints.size(); i++) {
+        auto parent = joints[i].parent;
+        globalTransforms[i] = parent >= 0 ? globalTransforms[parent] * joints[i].transformation : joints[i].transformation;
+        positions[i] = glm::vec3(globalTransforms[i][3]);
+        bindRadius = std::max(bindRadius, glm::length(positions[i] - positions[0]));
+    }
+
+    // Extent of each joint's subtree, measured from where it attaches to its parent
+    std::vector<float> extents(joints.size(), 0.0f);
+    for (size_t i = 0; i < joints.size(); i++) {
+        for (auto ancestor = static_cast<int32_t>(i); joints[ancestor].parent >= 0; ancestor = joints[ancestor].parent) {
+            auto distance = glm::length(positions[i] - positions[joints[ancestor].parent]);
+            extents[ancestor] = std::max(extents[ancestor], distance);
+        }
+    }
+
+    for (size_t i = 0; i < joints.size(); i++) {
+        if (joints[i].parent >= 0 && extents[i] < detailFraction * bindRadius) {
+            joints[i].detail = true;
+            detailJointCount++;
+        }
+    }
+}
+
+int32_t Skeleton::findJoint(const std::string& name) const {
+    auto it = jointIndices.find(name);
+    return it != jointIndices.end() ? it->second : -1;
+}
+
+void Skeleton::print() const {
+    std::vector<int> depths(joints.size(), 0);
+    for (size_t i = 0; i < joints.size(); i++) {
+        if (joints[i].parent >= 0) {
+            depths[i] = depths[joints[i].parent] + 1;
+        }
+
+        std::cout << std::string(depths[i] * 2, ' ') << joints[i].name << std::endl;
+    }
+}
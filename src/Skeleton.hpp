@@ -1,10 +1,16 @@
 #pragma once
 
 #include <vector>
+#include <string>
+#include <memory>
+#include <unordered_map>
 #include <iostream>
 
 #include <glm/glm.hpp>
 
+#include "Mesh.hpp"
+#include "Pose.hpp"
+
 struct Bone {
     Bone(std::string name, std::shared_ptr<Bone> parent, glm::mat4 transformation)
         : name(name), parent(parent), transformation(transformation) {}
@@ -27,14 +33,46 @@ struct Bone {
     }
 };
 
+struct Joint {
+    std::string name;
+    int32_t parent; // -1 for the root, always smaller than the joint's own index
+    glm::mat4 transformation;
+    JointPose bindPose;
+    
+    // Index into the bone palette and the inverse bind matrix, paletteIndex is -1 if no vertex references the joint
+    int32_t paletteIndex;
+    glm::mat4 offset;
+    
+    // Small joint near the end of a chain (fingers, toes, ...) that animation LOD may leave in its bind pose
+    bool detail;
+};
+
+/**
+ * Immutable joint hierarchy, shared by all models (and instances) loaded from the same file.
+ * Joints are stored flattened in parent-before-child order, so a pose can be built in a single pass.
+ */
 class Skeleton {
     
 public:
-    Skeleton(std::shared_ptr<Bone> root)  : root(root) {}
+    Skeleton(std::shared_ptr<Bone> root, const std::unordered_map<std::string, MeshBoneData>& boneData);
     
-    std::shared_ptr<Bone> getRoot() { return root; }
+    const std::vector<Joint>& getJoints() const { return joints; }
+    size_t getJointCount() const { return joints.size(); }
+    size_t getPaletteSize() const { return paletteSize; }
+    size_t getDetailJointCount() const { return detailJointCount; }
+    float getBindRadius() const { return bindRadius; }
+    
+    int32_t findJoint(const std::string& name) const;
+    void print() const;
     
 private:
-    std::shared_ptr<Bone> root;
+    std::vector<Joint> joints;
+    std::unordered_map<std::string, int32_t> jointIndices;
+    size_t paletteSize;
+    size_t detailJointCount;
+    float bindRadius;
+    
+    void addJoints(const std::shared_ptr<Bone>& bone, int32_t parent, const std::unordered_map<std::string, MeshBoneData>& boneData);
+    void markDetailJoints();
     
 };
@@ -0,0 +1,91 @@
+#include "StagingRing.hpp"
+
+#include <algorithm>
+
+#include "VulkanDevice.hpp"
+#include "UploadQueue.hpp"
+
+StagingRing::StagingRing(VulkanDevice& device, VkDeviceSize capacity) : device(device), capacity(capacity) {
+    device.createBuffer(capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, buffer, MemoryCategory::Staging);
+}
+
+StagingRing::~StagingRing() {
+    device.freeBuffer(buffer);
+}
+
+StagingAllocation StagingRing::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+    auto& uploadQueue = *device.uploadQueue;
+    size = std::max<VkDeviceSize>(size, 1);
+
+    if (size > capacity) {
+        VulkanBuffer temporaryBuffer;
+        device.createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                            temporaryBuffer, MemoryCategory::Staging, VulkanAllocationStrategy::Linear);
+        uploadQueue.freeAfterCompletion(temporaryBuffer);
+        return { temporaryBuffer.buffer, 0, temporaryBuffer.allocation.mapped };
+    }
+
+    VkDeviceSize offset;
+    while (true) {
+        // Opening the batch first guarantees that the id the region is tagged with gets submitted
+        uploadQueue.getCommandBuffer();
+        releaseCompletedRegions();
+
+        if (tryAllocate(size, alignment, offset)) {
+            break;
+        }
+
+        // The ring is full: submit the batch reading the newest regions if necessary and wait for the oldest one
+        auto batchId = uploadQueue.getRecordingBatchId();
+        if (regions.back().batchId == batchId) {
+            uploadQueue.submit();
+        }
+        uploadQueue.wait(regions.front().batchId);
+    }
+
+    head = offset + size;
+    auto batchId = uploadQueue.getRecordingBatchId();
+    if (!regions.empty() && regions.back().batchId == batchId) {
+        regions.back().end = head;
+    } else {
+        regions.push_back({ batchId, head });
+    }
+
+    return { buffer.buffer, offset, static_cast<char*>(buffer.allocation.mapped) + offset };
+}
+
+void StagingRing::releaseCompletedRegions() {
+    while (!regions.empty() && device.uploadQueue->isComplete(regions.front().batchId)) {
+        tail = regions.front().end;
+        regions.pop_front();
+    }
+
+    if (regions.empty()) {
+        head = 0;
+        tail = 0;
+    }
+}
+
+bool StagingRing::tryAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset) const {
+    auto alignedHead = (head + alignment - 1) / alignment * alignment;
+
+    if (regions.empty() || head > tail) {
+        // Free space after the head and, by wrapping around, before the tail
+        if (alignedHead + size <= capacity) {
+            offset = alignedHead;
+            return true;
+        }
+        if (!regions.empty() && size <= tail) {
+            offset = 0;
+            return true;
+        }
+        return false;
+    }
+
+    // Wrapped around: only the gap up to the tail is free, head == tail means the ring is full
+    if (head < tail && alignedHead + size <= tail) {
+        offset = alignedHead;
+        return true;
+    }
+    return false;
+}
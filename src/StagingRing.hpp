@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <deque>
+
+#include "VulkanBuffer.hpp"
+
+class VulkanDevice;
+
+/** Host-visible source range for a transfer recorded into the current upload batch */
+struct StagingAllocation {
+    VkBuffer buffer;
+    VkDeviceSize offset;
+    void* mapped;
+};
+
+/**
+ * Persistently mapped ring buffer that every CPU-to-GPU upload stages through. Space is handed out in submission order
+ * and reclaimed once the fence of the upload batch that read it has signalled, so no staging buffers are created while loading.
+ * Only uploads larger than the whole ring fall back to a temporary buffer.
+ */
+class StagingRing {
+
+public:
+    StagingRing(VulkanDevice& device, VkDeviceSize capacity = DEFAULT_CAPACITY);
+    virtual ~StagingRing();
+
+    /** The copy reading the allocation has to be recorded into the device's upload queue before the next allocation */
+    StagingAllocation allocate(VkDeviceSize size, VkDeviceSize alignment = 16);
+
+    VkDeviceSize getCapacity() const { return capacity; }
+
+    static const VkDeviceSize DEFAULT_CAPACITY = 32ull << 20;
+
+private:
+    struct Region {
+        uint64_t batchId; // Upload batch reading the region
+        VkDeviceSize end; // The region starts at the previous region's end
+    };
+
+    VulkanDevice& device;
+    VulkanBuffer buffer;
+    VkDeviceSize capacity;
+
+    VkDeviceSize head = 0; // Next free byte
+    VkDeviceSize tail = 0; // Start of the oldest region still in use
+    std::deque<Region> regions;
+
+    void releaseCompletedRegions();
+    bool tryAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset) const;
+
+};
@@ -0,0 +1,38 @@
+#include "UniformRing.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "VulkanDevice.hpp"
+
+UniformRing::UniformRing(VulkanDevice& device, uint32_t frameCount, VkDeviceSize frameCapacity) : device(device) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device.physicalDevice, &properties);
+    // Storage buffer offsets are used by bone palettes
+    alignment = std::max(properties.limits.minUniformBufferOffsetAlignment, properties.limits.minStorageBufferOffsetAlignment);
+
+    this->frameCapacity = (frameCapacity + alignment - 1) / alignment * alignment;
+    device.createBuffer(this->frameCapacity * frameCount, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, buffer, MemoryCategory::Uniform);
+}
+
+UniformRing::~UniformRing() {
+    device.freeBuffer(buffer);
+}
+
+void UniformRing::beginFrame(uint32_t frame) {
+    frameStart = frame * frameCapacity;
+    head = 0;
+}
+
+uint32_t UniformRing::push(const void* data, VkDeviceSize size) {
+    auto offset = (head + alignment - 1) / alignment * alignment;
+    if (offset + size > frameCapacity) {
+        throw std::runtime_error("Uniform data of the frame doesn't fit into the uniform ring.");
+    }
+
+    memcpy(static_cast<char*>(buffer.allocation.mapped) + frameStart + offset, data, size);
+    head = offset + size;
+    return static_cast<uint32_t>(frameStart + offset);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include "VulkanBuffer.hpp"
+
+class VulkanDevice;
+
+/**
+ * Persistently mapped buffer that all per-draw uniform data of a frame is linearly allocated from. Descriptors point at
+ * the buffer as VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC or VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC and select their
+ * data with the offsets returned by push().
+ * Every swap chain image has its own segment, which is reused once the image's previous frame has completed.
+ */
+class UniformRing {
+
+public:
+    UniformRing(VulkanDevice& device, uint32_t frameCount, VkDeviceSize frameCapacity = DEFAULT_FRAME_CAPACITY);
+    virtual ~UniformRing();
+
+    /** Starts writing into the segment of the frame, its previous contents must no longer be in use by the GPU */
+    void beginFrame(uint32_t frame);
+
+    /** Copies the data into the current frame's segment and returns its dynamic offset */
+    uint32_t push(const void* data, VkDeviceSize size);
+
+    template <typename T>
+    uint32_t push(const T& data) { return push(&data, sizeof(T)); }
+
+    VkBuffer getBuffer() const { return buffer.buffer; }
+
+    static const VkDeviceSize DEFAULT_FRAME_CAPACITY = 2ull << 20;
+
+private:
+    VulkanDevice& device;
+    VulkanBuffer buffer;
+    VkDeviceSize frameCapacity;
+    VkDeviceSize alignment;
+
+    VkDeviceSize frameStart = 0;
+    VkDeviceSize head = 0; // Relative to frameStart
+
+};
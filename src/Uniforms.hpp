@@ -1,239 +1,158 @@
 #pragma once
 
 #include <map>
+#include <vector>
+
+#include <glm/glm.hpp>
 
 #include "VulkanDevice.hpp"
 #include "VulkanSwapchain.hpp"
 #include "VulkanTexture.hpp"
 #include "VulkanFramebuffer.hpp"
 #include "Pipeline.hpp"
+#include "UniformRing.hpp"
+#include "DescriptorAllocator.hpp"
+#include "DescriptorLayoutCache.hpp"
 #include "Globals.hpp"
 
+/**
+ * Per-object data. The uniform struct is passed as push constants, descriptor set 1 (after the frame globals of
+ * FrameDescriptors) holds the bone palette of skinned objects at binding 0, followed by the textures and the shadow map.
+ */
 template <typename TUniformStruct>
 class Uniforms {
     
 public:
     TUniformStruct ubo;
+    std::vector<glm::mat4> boneTransforms; // MAX_BONES matrices if skinned, empty otherwise
     
-    Uniforms(VulkanDevice& device, size_t textureNum, bool addShadowMaps) : ubo(), addShadowMaps(addShadowMaps), device(device) {
+    Uniforms(VulkanDevice& device, size_t textureNum, bool addShadowMaps, bool skinned = false)
+            : ubo(), addShadowMaps(addShadowMaps), skinned(skinned), device(device) {
+        if (skinned) {
+            boneTransforms.resize(MAX_BONES, glm::mat4(1.0f));
+        }
         createDescriptorSetLayout(textureNum);
     }
     
-    virtual ~Uniforms() {
-        vkDestroyDescriptorSetLayout(device.device, descriptorSetLayout, nullptr);
-    }
-    
-    void initializeDescriptors(VulkanSwapchain& swapchain, VulkanFramebuffer& framebuffer) {
-        swapChainImageNumber = swapchain.imageNumber();
-        
-        createUniformBuffers();
-        createDescriptorPool();
-        createDescriptorSets(framebuffer);
-    }
+    virtual ~Uniforms() = default;
     
-    void destroyDescriptors() {
-        // Swapchain already destroyed, how should we get the number of images?
-        for (size_t i = 0; i < swapChainImageNumber; i++) {
-            device.freeBuffer(uniformBuffers[i]);
-            device.freeBuffer(globalsBuffers[i]);
-        }
-        
-        vkDestroyDescriptorPool(device.device, descriptorPool, nullptr);
+    /** The set is released by resetting the allocator, the bone palette points into the ring, which has to outlive it */
+    void initializeDescriptors(DescriptorAllocator& allocator, UniformRing& uniformRing, VulkanFramebuffer& framebuffer) {
+        createDescriptorSet(allocator, uniformRing, framebuffer);
     }
     
-    void bind(VkCommandBuffer commandBuffer, Pipeline& pipeline, size_t descriptorSetIndex) {
-        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getLayout(), 0, 1, &descriptorSets[descriptorSetIndex], 0, nullptr);
+    void bind(VkCommandBuffer commandBuffer, Pipeline& pipeline) {
+        vkCmdPushConstants(commandBuffer, pipeline.getLayout(), VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(TUniformStruct), &ubo);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getLayout(), SET_INDEX, 1, &descriptorSet, skinned ? 1 : 0, &bonesOffset);
     }
     
-    void update(size_t currentImage, Globals& globals) {
-        void* data;
-        vkMapMemory(device.device, uniformBuffers[currentImage].memory, 0, sizeof(ubo), 0, &data);
-        memcpy(data, &ubo, sizeof(ubo));
-        vkUnmapMemory(device.device, uniformBuffers[currentImage].memory);
-        
-        vkMapMemory(device.device, globalsBuffers[currentImage].memory, 0, sizeof(globals), 0, &data);
-        memcpy(data, &globals, sizeof(globals));
-        vkUnmapMemory(device.device, globalsBuffers[currentImage].memory);
+    /** Writes this frame's bone palette into the ring, bind() uses it until the next update */
+    void update(UniformRing& uniformRing) {
+        if (skinned) {
+            bonesOffset = uniformRing.push(boneTransforms.data(), sizeof(glm::mat4) * MAX_BONES);
+        }
     }
     
     void addTexture(uint32_t binding, std::shared_ptr<VulkanTexture> texture) { this->textures[binding] = texture; }
     
     VkDescriptorSetLayout getDescriptorSetLayout() { return descriptorSetLayout; }
+    bool isSkinned() const { return skinned; }
+    
+    static const uint32_t SET_INDEX = 1;
     
 private:
     std::map<uint32_t, std::shared_ptr<VulkanTexture>> textures;
     bool addShadowMaps;
+    bool skinned;
     
-    VkDescriptorSetLayout descriptorSetLayout;
+    VkDescriptorSetLayout descriptorSetLayout; // Owned by the device's layout cache
     VulkanDevice& device;
-    size_t swapChainImageNumber;
-    
-    std::vector<VulkanBuffer> uniformBuffers;
     
-    // TODO: only use a single memory per swap chain image instead of per object
-    std::vector<VulkanBuffer> globalsBuffers;
-    
-    VkDescriptorPool descriptorPool;
-    std::vector<VkDescriptorSet> descriptorSets;
+    VkDescriptorSet descriptorSet;
+    uint32_t bonesOffset = 0; // Of the bone palette in the uniform ring
     
     void createDescriptorSetLayout(size_t textureNum) {
         if (addShadowMaps) {
             textureNum++;
         }
         
-        std::vector<VkDescriptorSetLayoutBinding> bindings(textureNum + 2);
-        
-        bindings[0].binding = 0;
-        bindings[0].descriptorCount = 1;
-        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        bindings[0].pImmutableSamplers = nullptr;
-        bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        std::vector<VkDescriptorSetLayoutBinding> bindings;
         
-        bindings[1].binding = 1;
-        bindings[1].descriptorCount = 1;
-        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        bindings[1].pImmutableSamplers = nullptr;
-        bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-        
-        for (int i = 2; i < bindings.size(); i++) {
-            bindings[i].binding = i;
-            bindings[i].descriptorCount = 1;
-            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            bindings[i].pImmutableSamplers = nullptr;
-            bindings[i].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        if (skinned) {
+            VkDescriptorSetLayoutBinding bonesBinding = {};
+            bonesBinding.binding = 0;
+            bonesBinding.descriptorCount = 1;
+            bonesBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+            bonesBinding.pImmutableSamplers = nullptr;
+            bonesBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+            bindings.push_back(bonesBinding);
         }
         
-        VkDescriptorSetLayoutCreateInfo layoutInfo = {};
-        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
-        layoutInfo.pBindings = bindings.data();
-        
-        if (vkCreateDescriptorSetLayout(device.device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create descriptor set layout!");
+        // Textures start at binding 1 either way, so shaders don't depend on skinning
+        for (uint32_t i = 1; i < textureNum + 1; i++) {
+            VkDescriptorSetLayoutBinding textureBinding = {};
+            textureBinding.binding = i;
+            textureBinding.descriptorCount = 1;
+            textureBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            textureBinding.pImmutableSamplers = nullptr;
+            textureBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+            bindings.push_back(textureBinding);
         }
-    }
-    
-    void createUniformBuffers() {
-        uniformBuffers.resize(swapChainImageNumber);
         
-        globalsBuffers.resize(swapChainImageNumber);
-        
-        for (size_t i = 0; i < swapChainImageNumber; i++) {
-            device.createBuffer(sizeof(TUniformStruct), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uniformBuffers[i]);
-            device.createBuffer(sizeof(Globals), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, globalsBuffers[i]);
-        }
+        descriptorSetLayout = device.descriptorLayoutCache->getLayout(bindings);
     }
     
-    void createDescriptorPool() {
-        size_t textureNum = textures.size();
-        if (addShadowMaps) {
-            textureNum++;
+    void createDescriptorSet(DescriptorAllocator& allocator, UniformRing& uniformRing, VulkanFramebuffer& framebuffer) {
+        descriptorSet = allocator.allocate(descriptorSetLayout);
+        
+        std::vector<VkWriteDescriptorSet> descriptorWrites;
+        
+        // A single set serves every frame, the dynamic offset selects the frame's palette
+        VkDescriptorBufferInfo bonesInfo = {};
+        bonesInfo.buffer = uniformRing.getBuffer();
+        bonesInfo.offset = 0;
+        bonesInfo.range = sizeof(glm::mat4) * MAX_BONES;
+        
+        if (skinned) {
+            VkWriteDescriptorSet bonesWrite = {};
+            bonesWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            bonesWrite.dstSet = descriptorSet;
+            bonesWrite.dstBinding = 0;
+            bonesWrite.dstArrayElement = 0;
+            bonesWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+            bonesWrite.descriptorCount = 1;
+            bonesWrite.pBufferInfo = &bonesInfo;
+            descriptorWrites.push_back(bonesWrite);
         }
         
-        std::vector<VkDescriptorPoolSize> poolSizes(textureNum > 0 ? 2 : 1);
-        poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        poolSizes[0].descriptorCount = static_cast<uint32_t>(2 * swapChainImageNumber);
+        std::vector<VkDescriptorImageInfo> imageInfos(textures.size() + 1);
         
-        if (textureNum > 0) {
-            poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            poolSizes[1].descriptorCount = static_cast<uint32_t>(textureNum * swapChainImageNumber);
+        for (int j = 1; j < textures.size() + 1; j++) {
+            imageInfos[j-1] = textures[j]->getDescriptorImageInfo();
         }
         
-        VkDescriptorPoolCreateInfo poolInfo = {};
-        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-        poolInfo.pPoolSizes = poolSizes.data();
-        poolInfo.maxSets = static_cast<uint32_t>(swapChainImageNumber);
-        
-        if (vkCreateDescriptorPool(device.device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create descriptor pool!");
-        }
-    }
-    
-    void createDescriptorSets(VulkanFramebuffer& framebuffer) {
-        size_t textureNum = textures.size();
         if (addShadowMaps) {
-            textureNum++;
+            // Add the shadow map at the end
+            auto& shadowImageInfo = imageInfos[textures.size()];
+            shadowImageInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+            shadowImageInfo.imageView = framebuffer.shadowDepthImageView;
+            shadowImageInfo.sampler = framebuffer.shadowSampler;
         }
         
-        std::vector<VkDescriptorSetLayout> layouts(swapChainImageNumber, descriptorSetLayout);
-        VkDescriptorSetAllocateInfo allocInfo = {};
-        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocInfo.descriptorPool = descriptorPool;
-        allocInfo.descriptorSetCount = static_cast<uint32_t>(swapChainImageNumber);
-        allocInfo.pSetLayouts = layouts.data();
-        
-        descriptorSets.resize(swapChainImageNumber);
-        if (vkAllocateDescriptorSets(device.device, &allocInfo, descriptorSets.data()) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate descriptor sets!");
+        size_t imageNum = addShadowMaps ? textures.size() + 1 : textures.size();
+        for (size_t j = 0; j < imageNum; j++) {
+            VkWriteDescriptorSet imageWrite = {};
+            imageWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            imageWrite.dstSet = descriptorSet;
+            imageWrite.dstBinding = static_cast<uint32_t>(j + 1);
+            imageWrite.dstArrayElement = 0;
+            imageWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            imageWrite.descriptorCount = 1;
+            imageWrite.pImageInfo = &imageInfos[j];
+            descriptorWrites.push_back(imageWrite);
         }
         
-        for (size_t i = 0; i < swapChainImageNumber; i++) {
-            VkDescriptorBufferInfo localTransformInfo = {};
-            localTransformInfo.buffer = uniformBuffers[i].buffer;
-            localTransformInfo.offset = 0;
-            localTransformInfo.range = sizeof(TUniformStruct);
-            
-            VkDescriptorBufferInfo globalsInfo = {};
-            globalsInfo.buffer = globalsBuffers[i].buffer;
-            globalsInfo.offset = 0;
-            globalsInfo.range = sizeof(Globals);
-            
-            std::vector<VkWriteDescriptorSet> descriptorWrites(textureNum + 2);
-            
-            descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descriptorWrites[0].dstSet = descriptorSets[i];
-            descriptorWrites[0].dstBinding = 0;
-            descriptorWrites[0].dstArrayElement = 0;
-            descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            descriptorWrites[0].descriptorCount = 1;
-            descriptorWrites[0].pBufferInfo = &localTransformInfo;
-            
-            descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descriptorWrites[1].dstSet = descriptorSets[i];
-            descriptorWrites[1].dstBinding = 1;
-            descriptorWrites[1].dstArrayElement = 0;
-            descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            descriptorWrites[1].descriptorCount = 1;
-            descriptorWrites[1].pBufferInfo = &globalsInfo;
-            
-            std::vector<VkDescriptorImageInfo> imageInfos(textures.size());
-            
-            for (int j = 2; j < textures.size() + 2; j++) {
-                imageInfos[j-2] = textures[j]->getDescriptorImageInfo();
-            }
-            
-            for (int j = 2; j < textures.size() + 2; j++) {
-                auto& imageInfo = imageInfos[j-2];
-                
-                descriptorWrites[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                descriptorWrites[j].dstSet = descriptorSets[i];
-                descriptorWrites[j].dstBinding = j;
-                descriptorWrites[j].dstArrayElement = 0;
-                descriptorWrites[j].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                descriptorWrites[j].descriptorCount = 1;
-                descriptorWrites[j].pImageInfo = &imageInfo;
-            }
-            
-            if (addShadowMaps) {
-                // Add the shadow map at the end
-                VkDescriptorImageInfo imageInfo = {};
-                imageInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
-                imageInfo.imageView = framebuffer.shadowDepthImageView;
-                imageInfo.sampler = framebuffer.shadowSampler;
-                
-                size_t index = textures.size() + 2;
-                descriptorWrites[index].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                descriptorWrites[index].dstSet = descriptorSets[i];
-                descriptorWrites[index].dstBinding = static_cast<uint32_t>(index);
-                descriptorWrites[index].dstArrayElement = 0;
-                descriptorWrites[index].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                descriptorWrites[index].descriptorCount = 1;
-                descriptorWrites[index].pImageInfo = &imageInfo;
-            }
-            
-            vkUpdateDescriptorSets(device.device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
-        }
+        vkUpdateDescriptorSets(device.device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
     }
-    
+
 };
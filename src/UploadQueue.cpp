@@ -0,0 +1,180 @@
+#include "UploadQueue.hpp"
+
+#include <stdexcept>
+
+#include "VulkanDevice.hpp"
+
+UploadQueue::UploadQueue(VulkanDevice& device) : device(device) {
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = device.findQueueFamilies(device.physicalDevice).graphicsFamily.value();
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+    if (vkCreateCommandPool(device.device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create upload command pool!");
+    }
+}
+
+UploadQueue::~UploadQueue() {
+    flush();
+
+    for (auto& batch : freeBatches) {
+        vkDestroyFence(device.device, batch.fence, nullptr);
+    }
+    vkDestroyCommandPool(device.device, commandPool, nullptr);
+}
+
+VkCommandBuffer UploadQueue::getCommandBuffer() {
+    if (recording) {
+        return currentBatch.commandBuffer;
+    }
+
+    collectCompletedBatches();
+
+    if (!freeBatches.empty()) {
+        currentBatch = std::move(freeBatches.back());
+        freeBatches.pop_back();
+        vkResetCommandBuffer(currentBatch.commandBuffer, 0);
+    } else {
+        currentBatch = Batch();
+
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = commandPool;
+        allocInfo.commandBufferCount = 1;
+        vkAllocateCommandBuffers(device.device, &allocInfo, &currentBatch.commandBuffer);
+
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        if (vkCreateFence(device.device, &fenceInfo, nullptr, &currentBatch.fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create upload fence!");
+        }
+    }
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(currentBatch.commandBuffer, &beginInfo);
+
+    recording = true;
+    return currentBatch.commandBuffer;
+}
+
+VkCommandBuffer UploadQueue::getBufferCopyCommandBuffer(VkBuffer srcBuffer, VkDeviceSize srcOffset, VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize size) {
+    auto commandBuffer = getCommandBuffer();
+
+    // Reading data an earlier copy wrote, or overwriting it, has to wait for that copy
+    if (overlapsWrittenRange(srcBuffer, srcOffset, size) || overlapsWrittenRange(dstBuffer, dstOffset, size)) {
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                             1, &barrier, 0, nullptr, 0, nullptr);
+        writtenRanges.clear();
+    }
+
+    writtenRanges.push_back({ dstBuffer, dstOffset, size });
+    return commandBuffer;
+}
+
+void UploadQueue::waitForVertexInput() {
+    auto commandBuffer = getCommandBuffer();
+    if (waitsForVertexInput) {
+        return;
+    }
+
+    // Only a write-after-read hazard, an execution dependency is enough
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                         0, nullptr, 0, nullptr, 0, nullptr);
+    waitsForVertexInput = true;
+}
+
+bool UploadQueue::overlapsWrittenRange(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size) const {
+    for (auto& range : writtenRanges) {
+        if (range.buffer == buffer && offset < range.offset + range.size && range.offset < offset + size) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void UploadQueue::freeAfterCompletion(const VulkanBuffer& buffer) {
+    getCommandBuffer();
+    currentBatch.stagingBuffers.push_back(buffer);
+}
+
+uint64_t UploadQueue::submit() {
+    if (!recording) {
+        return lastSubmittedId;
+    }
+
+    // Make the copied vertex, index and uniform data visible to everything submitted later
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT
+        | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(currentBatch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                         1, &barrier, 0, nullptr, 0, nullptr);
+
+    vkEndCommandBuffer(currentBatch.commandBuffer);
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &currentBatch.commandBuffer;
+
+    if (vkQueueSubmit(device.graphicsQueue, 1, &submitInfo, currentBatch.fence) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit upload batch!");
+    }
+
+    writtenRanges.clear();
+    waitsForVertexInput = false;
+    currentBatch.id = ++lastSubmittedId;
+    pendingBatches.push_back(std::move(currentBatch));
+    recording = false;
+    return lastSubmittedId;
+}
+
+bool UploadQueue::isComplete(uint64_t batchId) {
+    collectCompletedBatches();
+    return batchId <= lastCompletedId;
+}
+
+void UploadQueue::wait(uint64_t batchId) {
+    if (batchId <= lastCompletedId) {
+        return;
+    }
+
+    std::vector<VkFence> fences;
+    for (auto& batch : pendingBatches) {
+        if (batch.id <= batchId) {
+            fences.push_back(batch.fence);
+        }
+    }
+    vkWaitForFences(device.device, static_cast<uint32_t>(fences.size()), fences.data(), VK_TRUE, UINT64_MAX);
+    collectCompletedBatches();
+}
+
+void UploadQueue::collectCompletedBatches() {
+    // Batches complete in submission order on a single queue
+    size_t completed = 0;
+    while (completed < pendingBatches.size() && vkGetFenceStatus(device.device, pendingBatches[completed].fence) == VK_SUCCESS) {
+        lastCompletedId = pendingBatches[completed].id;
+        recycle(pendingBatches[completed]);
+        completed++;
+    }
+    pendingBatches.erase(pendingBatches.begin(), pendingBatches.begin() + completed);
+}
+
+void UploadQueue::recycle(Batch& batch) {
+    for (auto& buffer : batch.stagingBuffers) {
+        device.freeBuffer(buffer);
+    }
+    batch.stagingBuffers.clear();
+
+    vkResetFences(device.device, 1, &batch.fence);
+    freeBatches.push_back(std::move(batch));
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <cstdint>
+
+#include "VulkanBuffer.hpp"
+
+class VulkanDevice;
+
+/**
+ * Collects transfer commands (buffer copies, image copies and layout transitions) into batches that are submitted
+ * together with a fence, instead of waiting for the queue after every single command.
+ * Work recorded before the renderer submits a frame is always submitted first, so callers only need to wait when the CPU
+ * depends on the result.
+ */
+class UploadQueue {
+
+public:
+    explicit UploadQueue(VulkanDevice& device);
+    virtual ~UploadQueue();
+
+    /** The command buffer of the batch being recorded, a new batch is started if there is none */
+    VkCommandBuffer getCommandBuffer();
+
+    /**
+     * Command buffer for a copy between the two buffer ranges. Copies in a batch aren't ordered against each other, so a
+     * barrier is recorded first if an earlier copy of the batch wrote to either range.
+     */
+    VkCommandBuffer getBufferCopyCommandBuffer(VkBuffer srcBuffer, VkDeviceSize srcOffset, VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize size);
+
+    /**
+     * Makes the rest of the batch wait until work submitted before it, like frames in flight, stopped reading vertex and
+     * index buffers, so geometry they draw can be overwritten. Recorded once per batch.
+     */
+    void waitForVertexInput();
+
+    /** Frees a staging buffer once the batch it was used in has completed */
+    void freeAfterCompletion(const VulkanBuffer& buffer);
+
+    /** Submits the batch being recorded and returns its id, or the id of the last submitted batch if nothing was recorded */
+    uint64_t submit();
+
+    /** Id the batch being recorded will get when it is submitted */
+    uint64_t getRecordingBatchId() const { return lastSubmittedId + 1; }
+
+    bool isComplete(uint64_t batchId);
+    void wait(uint64_t batchId);
+
+    /** Submits and waits for everything recorded so far */
+    void flush() { wait(submit()); }
+
+private:
+    struct BufferRange {
+        VkBuffer buffer;
+        VkDeviceSize offset;
+        VkDeviceSize size;
+    };
+
+    struct Batch {
+        uint64_t id;
+        VkCommandBuffer commandBuffer;
+        VkFence fence;
+        std::vector<VulkanBuffer> stagingBuffers;
+    };
+
+    VulkanDevice& device;
+    VkCommandPool commandPool;
+
+    bool recording = false;
+    Batch currentBatch;
+    std::vector<BufferRange> writtenRanges; // Copy destinations in the batch being recorded since its last barrier
+    bool waitsForVertexInput = false; // Whether the batch being recorded has the barrier of waitForVertexInput
+    std::vector<Batch> pendingBatches; // Submitted, oldest first
+    std::vector<Batch> freeBatches; // Completed, command buffer and fence can be reused
+
+    uint64_t lastSubmittedId = 0;
+    uint64_t lastCompletedId = 0;
+
+    bool overlapsWrittenRange(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size) const;
+    void collectCompletedBatches();
+    void recycle(Batch& batch);
+
+};
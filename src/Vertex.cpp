@@ -1,58 +1,177 @@
 #include "Vertex.hpp"
 
-VkVertexInputBindingDescription Vertex::getBindingDescription() {
+#include <cmath>
+#include <stdexcept>
+#include <algorithm>
+
+VkVertexInputBindingDescription Vertex::getBindingDescription(VertexFormat format) {
     VkVertexInputBindingDescription bindingDescription = {};
     bindingDescription.binding = 0;
-    bindingDescription.stride = sizeof(Vertex);
+    bindingDescription.stride = format == VertexFormat::Packed ? sizeof(PackedVertex) : sizeof(Vertex);
     bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
     
     return bindingDescription;
 }
 
-std::array<VkVertexInputAttributeDescription, 7> Vertex::getAttributeDescriptions() {
+std::array<VkVertexInputAttributeDescription, 7> Vertex::getAttributeDescriptions(VertexFormat format) {
     std::array<VkVertexInputAttributeDescription, 7> attributeDescriptions = {};
     
-    attributeDescriptions[0].binding = 0;
-    attributeDescriptions[0].location = 0;
+    for (uint32_t i = 0; i < attributeDescriptions.size(); i++) {
+        attributeDescriptions[i].binding = 0;
+        attributeDescriptions[i].location = i;
+    }
+    
+    if (format == VertexFormat::Packed) {
+        attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+        attributeDescriptions[0].offset = offsetof(PackedVertex, pos);
+        
+        attributeDescriptions[1].format = VK_FORMAT_R16G16_SNORM;
+        attributeDescriptions[1].offset = offsetof(PackedVertex, normal);
+        
+        attributeDescriptions[2].format = VK_FORMAT_R8G8B8A8_UNORM;
+        attributeDescriptions[2].offset = offsetof(PackedVertex, color);
+        
+        attributeDescriptions[3].format = VK_FORMAT_R16G16_SFLOAT;
+        attributeDescriptions[3].offset = offsetof(PackedVertex, texCoord);
+        
+        attributeDescriptions[4].format = VK_FORMAT_R8G8B8A8_SNORM;
+        attributeDescriptions[4].offset = offsetof(PackedVertex, tangent);
+        
+        attributeDescriptions[5].format = VK_FORMAT_R8G8B8A8_UINT;
+        attributeDescriptions[5].offset = offsetof(PackedVertex, boneIds);
+        
+        attributeDescriptions[6].format = VK_FORMAT_R8G8B8A8_UNORM;
+        attributeDescriptions[6].offset = offsetof(PackedVertex, boneWeights);
+        
+        return attributeDescriptions;
+    }
+    
     attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
     attributeDescriptions[0].offset = offsetof(Vertex, pos);
     
-    attributeDescriptions[1].binding = 0;
-    attributeDescriptions[1].location = 1;
     attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
     attributeDescriptions[1].offset = offsetof(Vertex, normal);
     
-    attributeDescriptions[2].binding = 0;
-    attributeDescriptions[2].location = 2;
     attributeDescriptions[2].format = VK_FORMAT_R32G32B32_SFLOAT;
     attributeDescriptions[2].offset = offsetof(Vertex, color);
     
-    attributeDescriptions[3].binding = 0;
-    attributeDescriptions[3].location = 3;
     attributeDescriptions[3].format = VK_FORMAT_R32G32_SFLOAT;
     attributeDescriptions[3].offset = offsetof(Vertex, texCoord);
     
-    attributeDescriptions[4].binding = 0;
-    attributeDescriptions[4].location = 4;
     attributeDescriptions[4].format = VK_FORMAT_R32G32B32A32_SFLOAT;
     attributeDescriptions[4].offset = offsetof(Vertex, tangent);
     
-    attributeDescriptions[5].binding = 0;
-    attributeDescriptions[5].location = 5;
     attributeDescriptions[5].format = VK_FORMAT_R32G32B32A32_UINT;
     attributeDescriptions[5].offset = offsetof(Vertex, boneIds);
     
-    attributeDescriptions[6].binding = 0;
-    attributeDescriptions[6].location = 6;
     attributeDescriptions[6].format = VK_FORMAT_R32G32B32A32_SFLOAT;
     attributeDescriptions[6].offset = offsetof(Vertex, boneWeights);
     
     return attributeDescriptions;
 }
 
+std::vector<VkVertexInputBindingDescription> Vertex::getDepthBindingDescriptions(VertexFormat format, bool skinned) {
+    std::vector<VkVertexInputBindingDescription> bindingDescriptions(skinned ? 2 : 1);
+    
+    bindingDescriptions[0].binding = 0;
+    bindingDescriptions[0].stride = sizeof(glm::vec3);
+    bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    
+    if (skinned) {
+        bindingDescriptions[1].binding = 1;
+        bindingDescriptions[1].stride = getBoneStreamStride(format);
+        bindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    }
+    
+    return bindingDescriptions;
+}
+
+std::vector<VkVertexInputAttributeDescription> Vertex::getDepthAttributeDescriptions(VertexFormat format, bool skinned) {
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions(skinned ? 3 : 1);
+    
+    attributeDescriptions[0].binding = 0;
+    attributeDescriptions[0].location = 0;
+    attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+    attributeDescriptions[0].offset = 0;
+    
+    if (skinned) {
+        bool packed = format == VertexFormat::Packed;
+        
+        attributeDescriptions[1].binding = 1;
+        attributeDescriptions[1].location = 5;
+        attributeDescriptions[1].format = packed ? VK_FORMAT_R8G8B8A8_UINT : VK_FORMAT_R32G32B32A32_UINT;
+        attributeDescriptions[1].offset = 0;
+        
+        attributeDescriptions[2].binding = 1;
+        attributeDescriptions[2].location = 6;
+        attributeDescriptions[2].format = packed ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R32G32B32A32_SFLOAT;
+        attributeDescriptions[2].offset = getBoneStreamStride(format) / 2;
+    }
+    
+    return attributeDescriptions;
+}
+
+uint32_t Vertex::getBoneStreamStride(VertexFormat format) {
+    // Bone ids followed by weights
+    return format == VertexFormat::Packed ? 2 * BONES_PER_VERTEX * sizeof(uint8_t) : BONES_PER_VERTEX * (sizeof(uint32_t) + sizeof(float));
+}
+
 bool Vertex::operator==(const Vertex& other) const {
     return pos == other.pos && normal == other.normal && color == other.color
         && texCoord == other.texCoord && tangent == other.tangent
-        && boneIds == other.boneIds && boneWeights == other.boneWeights;
+        && std::equal(boneIds, boneIds + BONES_PER_VERTEX, other.boneIds)
+        && std::equal(boneWeights, boneWeights + BONES_PER_VERTEX, other.boneWeights);
+}
+
+
+PackedVertex PackedVertex::fromVertex(const Vertex& vertex) {
+    PackedVertex packed = {};
+    packed.pos = vertex.pos;
+    packed.normal = glm::packSnorm2x16(encodeOctahedral(vertex.normal));
+    
+    auto tangent = encodeOctahedral(glm::vec3(vertex.tangent));
+    packed.tangent = glm::packSnorm4x8(glm::vec4(tangent.x, tangent.y, vertex.tangent.w < 0.0f ? -1.0f : 1.0f, 0.0f));
+    
+    packed.texCoord = glm::packHalf2x16(vertex.texCoord);
+    packed.color = glm::packUnorm4x8(glm::clamp(vertex.color, 0.0f, 1.0f));
+    
+    uint32_t weightSum = 0;
+    size_t largest = 0;
+    for (size_t i = 0; i < Vertex::BONES_PER_VERTEX; i++) {
+        if (vertex.boneIds[i] > UINT8_MAX) {
+            throw std::runtime_error("Packed vertices only support up to 256 bones.");
+        }
+        
+        packed.boneIds[i] = static_cast<uint8_t>(vertex.boneIds[i]);
+        packed.boneWeights[i] = static_cast<uint8_t>(std::round(glm::clamp(vertex.boneWeights[i], 0.0f, 1.0f) * 255.0f));
+        weightSum += packed.boneWeights[i];
+        
+        if (vertex.boneWeights[i] > vertex.boneWeights[largest]) {
+            largest = i;
+        }
+    }
+    
+    // Rounding can make the weights of a skinned vertex miss 1, give the difference to the strongest influence
+    if (weightSum != 0) {
+        packed.boneWeights[largest] = static_cast<uint8_t>(glm::clamp(static_cast<int>(packed.boneWeights[largest]) + 255 - static_cast<int>(weightSum), 0, 255));
+    }
+    
+    return packed;
 }
 
+glm::vec2 PackedVertex::encodeOctahedral(glm::vec3 direction) {
+    float length = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+    if (length == 0.0f) {
+        return glm::vec2(0.0f);
+    }
+    
+    direction /= length;
+    glm::vec2 encoded(direction.x, direction.y);
+    
+    // Fold the lower hemisphere over the diagonals
+    if (direction.z < 0.0f) {
+        encoded.x = (1.0f - std::abs(direction.y)) * (direction.x >= 0.0f ? 1.0f : -1.0f);
+        encoded.y = (1.0f - std::abs(direction.x)) * (direction.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return encoded;
+}
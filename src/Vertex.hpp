@@ -1,12 +1,20 @@
 #pragma once
 
 #include <array>
+#include <vector>
 
 #include <vulkan/vulkan.h>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
 #include <glm/gtx/hash.hpp>
+#include <glm/gtc/packing.hpp>
+
+/** Layout of a mesh's vertex buffer on the GPU, the CPU side always keeps full-precision Vertex data */
+enum class VertexFormat {
+    Full, // Vertex as is, 96 bytes
+    Packed // PackedVertex, 36 bytes. Vertex shaders must be compiled with PACKED_VERTEX.
+};
 
 struct Vertex {
     static const size_t BONES_PER_VERTEX = 4;
@@ -19,18 +27,58 @@ struct Vertex {
     uint32_t boneIds[BONES_PER_VERTEX];
     float boneWeights[BONES_PER_VERTEX];
     
-    static VkVertexInputBindingDescription getBindingDescription();
-    static std::array<VkVertexInputAttributeDescription, 7> getAttributeDescriptions();
+    static VkVertexInputBindingDescription getBindingDescription(VertexFormat format = VertexFormat::Full);
+    static std::array<VkVertexInputAttributeDescription, 7> getAttributeDescriptions(VertexFormat format = VertexFormat::Full);
+    
+    /**
+     * Layout for depth-only passes: tightly packed positions in binding 0 and, for skinned pipelines,
+     * bone ids and weights in binding 1 (same locations as in the interleaved layout)
+     */
+    static std::vector<VkVertexInputBindingDescription> getDepthBindingDescriptions(VertexFormat format, bool skinned);
+    static std::vector<VkVertexInputAttributeDescription> getDepthAttributeDescriptions(VertexFormat format, bool skinned);
+    static uint32_t getBoneStreamStride(VertexFormat format);
     
     bool operator==(const Vertex& other) const;
 };
 
+/**
+ * Quantized vertex: octahedral-encoded normal (snorm16) and tangent (snorm8, with the bitangent sign in z),
+ * half-float UVs, RGBA8 color, 8-bit bone ids and unorm8 bone weights.
+ */
+struct PackedVertex {
+    glm::vec3 pos;
+    uint32_t normal;
+    uint32_t tangent;
+    uint32_t texCoord;
+    uint32_t color;
+    uint8_t boneIds[Vertex::BONES_PER_VERTEX];
+    uint8_t boneWeights[Vertex::BONES_PER_VERTEX];
+    
+    static PackedVertex fromVertex(const Vertex& vertex);
+    static glm::vec2 encodeOctahedral(glm::vec3 direction);
+};
+
 namespace std {
+    /** Hashes every attribute, so vertices that only differ in normal, tangent or skinning don't collide */
     template<> struct hash<Vertex> {
         size_t operator()(Vertex const& vertex) const {
-            return ((hash<glm::vec3>()(vertex.pos) ^
-                    (hash<glm::vec4>()(vertex.color) << 1)) >> 1) ^
-                    (hash<glm::vec2>()(vertex.texCoord) << 1);
+            size_t seed = 0;
+            combine(seed, hash<glm::vec3>()(vertex.pos));
+            combine(seed, hash<glm::vec3>()(vertex.normal));
+            combine(seed, hash<glm::vec4>()(vertex.color));
+            combine(seed, hash<glm::vec2>()(vertex.texCoord));
+            combine(seed, hash<glm::vec4>()(vertex.tangent));
+            
+            for (size_t i = 0; i < Vertex::BONES_PER_VERTEX; i++) {
+                combine(seed, hash<uint32_t>()(vertex.boneIds[i]));
+                combine(seed, hash<float>()(vertex.boneWeights[i]));
+            }
+            return seed;
+        }
+        
+    private:
+        static void combine(size_t& seed, size_t value) {
+            seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
         }
     };
 }
@@ -1,10 +1,9 @@
 #pragma once
 
 #include <vulkan/vulkan.h>
-#include "VulkanDevice.hpp"
+#include "VulkanMemoryAllocator.hpp"
 
-// TODO: use an allocator
 struct VulkanBuffer {
     VkBuffer buffer;
-    VkDeviceMemory memory;
+    VulkanAllocation allocation;
 };
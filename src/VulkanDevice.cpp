@@ -5,6 +5,11 @@
 
 #include "VulkanExtensionHelper.hpp"
 #include "VulkanUtils.hpp"
+#include "GeometryArena.hpp"
+#include "UploadQueue.hpp"
+#include "StagingRing.hpp"
+#include "DescriptorLayoutCache.hpp"
+#include "BindlessResources.hpp"
 
 const std::vector<const char*> VulkanDevice::validationLayers = {
     "VK_LAYER_KHRONOS_validation"
@@ -22,9 +27,28 @@ VulkanDevice::VulkanDevice(GLFWwindow* window): window(window) {
     pickPhysicalDevice();
     createLogicalDevice();
     createCommandPool();
+    
+    auto getMemoryProperties2 = memoryBudgetEnabled
+        ? (PFN_vkGetPhysicalDeviceMemoryProperties2KHR) vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties2KHR") : nullptr;
+    memoryAllocator = std::make_unique<VulkanMemoryAllocator>(device, physicalDevice, getMemoryProperties2);
+    uploadQueue = std::make_unique<UploadQueue>(*this);
+    stagingRing = std::make_unique<StagingRing>(*this);
+    descriptorLayoutCache = std::make_unique<DescriptorLayoutCache>(device);
+    if (descriptorIndexingEnabled) {
+        bindlessResources = std::make_unique<BindlessResources>(*this);
+    }
 }
 
 VulkanDevice::~VulkanDevice() {
+    bindlessResources.reset();
+    uploadQueue.reset();
+    stagingRing.reset();
+    for (auto& arena : geometryArenas) {
+        arena.reset();
+    }
+    memoryAllocator.reset();
+    descriptorLayoutCache.reset();
+    
     if (enableValidationLayers) {
         VulkanExtensionHelper::DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
     }
@@ -53,6 +77,12 @@ void VulkanDevice::createInstance() {
     createInfo.pApplicationInfo = &appInfo;
     
     auto extensions = VulkanExtensionHelper::getRequiredExtensions(enableValidationLayers);
+    
+    // Needed to query VK_EXT_memory_budget and the descriptor indexing features on Vulkan 1.0
+    if (VulkanExtensionHelper::isInstanceExtensionSupported(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME)) {
+        extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+        physicalDeviceProperties2Enabled = true;
+    }
     createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
     createInfo.ppEnabledExtensionNames = extensions.data();
     
@@ -138,13 +168,34 @@ void VulkanDevice::createLogicalDevice() {
     VkDeviceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     
+    auto extensions = deviceExtensions;
+    if (physicalDeviceProperties2Enabled && VulkanExtensionHelper::isDeviceExtensionSupported(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)) {
+        extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        memoryBudgetEnabled = true;
+    }
+    
+    // Only the features the bindless texture array relies on, see BindlessResources
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures = {};
+    descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    if (checkDescriptorIndexingSupport()) {
+        extensions.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+        extensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+        descriptorIndexingFeatures.runtimeDescriptorArray = VK_TRUE;
+        descriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+        descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        deviceFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+        createInfo.pNext = &descriptorIndexingFeatures;
+        descriptorIndexingEnabled = true;
+    }
+    
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
     
     createInfo.pEnabledFeatures = &deviceFeatures;
     
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
     
     if (enableValidationLayers) {
         createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
@@ -167,13 +218,15 @@ void VulkanDevice::createCommandPool() {
     VkCommandPoolCreateInfo poolInfo = {};
     poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT; // Frame command buffers are re-recorded
     
     if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
         throw std::runtime_error("failed to create graphics command pool!");
     }
 }
 
-void VulkanDevice::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VulkanBuffer& buffer) {
+void VulkanDevice::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VulkanBuffer& buffer,
+                                MemoryCategory category, VulkanAllocationStrategy strategy) {
     VkBufferCreateInfo bufferInfo = {};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bufferInfo.size = size;
@@ -187,21 +240,21 @@ void VulkanDevice::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkM
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(device, buffer.buffer, &memRequirements);
     
-    VkMemoryAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = VulkanUtils::findMemoryType(physicalDevice, memRequirements.memoryTypeBits, properties);
-    
-    if (vkAllocateMemory(device, &allocInfo, nullptr, &buffer.memory) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate buffer memory!");
-    }
-    
-    vkBindBufferMemory(device, buffer.buffer, buffer.memory, 0);
+    buffer.allocation = memoryAllocator->allocate(memRequirements, properties, VulkanResourceKind::Buffer, category, strategy);
+    vkBindBufferMemory(device, buffer.buffer, buffer.allocation.memory, buffer.allocation.offset);
 }
 
 void VulkanDevice::freeBuffer(VulkanBuffer& buffer) {
     vkDestroyBuffer(device, buffer.buffer, nullptr);
-    vkFreeMemory(device, buffer.memory, nullptr);
+    memoryAllocator->free(buffer.allocation);
+}
+
+GeometryArena& VulkanDevice::getGeometryArena(VertexFormat format) {
+    auto& arena = geometryArenas[static_cast<size_t>(format)];
+    if (!arena) {
+        arena = std::make_unique<GeometryArena>(*this, format);
+    }
+    return *arena;
 }
 
 bool VulkanDevice::checkValidationLayerSupport() {
@@ -270,6 +323,34 @@ bool VulkanDevice::checkDeviceExtensionSupport(VkPhysicalDevice device) {
     return requiredExtensions.empty();
 }
 
+bool VulkanDevice::checkDescriptorIndexingSupport() {
+    // Vulkan 1.0 needs the extension's dependencies and vkGetPhysicalDeviceFeatures2KHR to query the features
+    if (!physicalDeviceProperties2Enabled
+            || !VulkanExtensionHelper::isDeviceExtensionSupported(physicalDevice, VK_KHR_MAINTENANCE3_EXTENSION_NAME)
+            || !VulkanExtensionHelper::isDeviceExtensionSupported(physicalDevice, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)) {
+        return false;
+    }
+
+    auto getFeatures2 = (PFN_vkGetPhysicalDeviceFeatures2KHR) vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR");
+    if (getFeatures2 == nullptr) {
+        return false;
+    }
+
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures = {};
+    descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
+    VkPhysicalDeviceFeatures2KHR features = {};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+    features.pNext = &descriptorIndexingFeatures;
+    getFeatures2(physicalDevice, &features);
+
+    return features.features.shaderSampledImageArrayDynamicIndexing
+        && descriptorIndexingFeatures.runtimeDescriptorArray
+        && descriptorIndexingFeatures.descriptorBindingPartiallyBound
+        && descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind
+        && descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending;
+}
+
 VulkanDevice::QueueFamilyIndices VulkanDevice::findQueueFamilies(VkPhysicalDevice device) {
     QueueFamilyIndices indices;
     
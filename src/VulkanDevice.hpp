@@ -2,12 +2,21 @@
 
 #include <optional>
 #include <vector>
+#include <memory>
 #include <iostream>
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
 #include "VulkanBuffer.hpp"
+#include "VulkanMemoryAllocator.hpp"
+
+class GeometryArena;
+class UploadQueue;
+class StagingRing;
+class DescriptorLayoutCache;
+class BindlessResources;
+enum class VertexFormat;
 
 class VulkanDevice {
     
@@ -23,6 +32,11 @@ public:
     VkPhysicalDevice physicalDevice;
     VkDevice device;
     VkCommandPool commandPool;
+    std::unique_ptr<VulkanMemoryAllocator> memoryAllocator;
+    std::unique_ptr<UploadQueue> uploadQueue; // Batches transfers, see VulkanUtils::copyBuffer
+    std::unique_ptr<StagingRing> stagingRing; // Source of all uploads to device-local memory
+    std::unique_ptr<DescriptorLayoutCache> descriptorLayoutCache; // Shares identical descriptor set layouts
+    std::unique_ptr<BindlessResources> bindlessResources; // Null if descriptor indexing isn't supported
     
     VkQueue graphicsQueue;
     VkQueue presentQueue;
@@ -51,9 +65,13 @@ public:
         std::vector<VkPresentModeKHR> presentModes;
     };
     
-    void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VulkanBuffer& buffer);
+    void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VulkanBuffer& buffer,
+                      MemoryCategory category, VulkanAllocationStrategy strategy = VulkanAllocationStrategy::General);
     void freeBuffer(VulkanBuffer& buffer);
     
+    /** Shared vertex and index buffers for all meshes of the format, created on first use */
+    GeometryArena& getGeometryArena(VertexFormat format);
+    
     static const std::vector<const char*> validationLayers;
     
     static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT messageType, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData, void* pUserData);
@@ -66,6 +84,12 @@ public:
 private:
     static const std::vector<const char*> deviceExtensions;
     
+    std::unique_ptr<GeometryArena> geometryArenas[2]; // Indexed by VertexFormat
+    
+    bool physicalDeviceProperties2Enabled = false;
+    bool memoryBudgetEnabled = false;
+    bool descriptorIndexingEnabled = false;
+    
     void createInstance();
     void createSurface();
     void setupDebugMessenger();
@@ -77,6 +101,7 @@ private:
     bool checkValidationLayerSupport();
     bool isDeviceSuitable(VkPhysicalDevice device);
     bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+    bool checkDescriptorIndexingSupport();
     SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
     VkSampleCountFlagBits getMaxMsaaSamples();
 };
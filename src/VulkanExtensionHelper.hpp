@@ -12,6 +12,8 @@ public:
     static VkResult CreateDebugUtilsMessengerEXT(VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDebugUtilsMessengerEXT* pDebugMessenger);
     static void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT debugMessenger, const VkAllocationCallbacks* pAllocator);
     static std::vector<const char*> getRequiredExtensions(bool enableValidationLayers);
+    static bool isInstanceExtensionSupported(const char* name);
+    static bool isDeviceExtensionSupported(VkPhysicalDevice physicalDevice, const char* name);
     static void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo, PFN_vkDebugUtilsMessengerCallbackEXT callback);
     
 };
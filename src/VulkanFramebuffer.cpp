@@ -21,22 +21,22 @@ VulkanFramebuffer::~VulkanFramebuffer() {
     
     vkDestroyImageView(vulkanDevice.device, shadowDepthImageView, nullptr);
     vkDestroyImage(vulkanDevice.device, shadowDepthImage, nullptr);
-    vkFreeMemory(vulkanDevice.device, shadowDepthImageMemory, nullptr);
+    vulkanDevice.memoryAllocator->free(shadowDepthImageMemory);
 
     vkDestroyImageView(vulkanDevice.device, colorImageView, nullptr);
     vkDestroyImage(vulkanDevice.device, colorImage, nullptr);
-    vkFreeMemory(vulkanDevice.device, colorImageMemory, nullptr);
+    vulkanDevice.memoryAllocator->free(colorImageMemory);
 
     vkDestroySampler(vulkanDevice.device, shadowSampler, nullptr);
     vkDestroyImageView(vulkanDevice.device, depthImageView, nullptr);
     vkDestroyImage(vulkanDevice.device, depthImage, nullptr);
-    vkFreeMemory(vulkanDevice.device, depthImageMemory, nullptr);
+    vulkanDevice.memoryAllocator->free(depthImageMemory);
 }
 
 void VulkanFramebuffer::createColorResources() {
     VkFormat colorFormat = swapchain.imageFormat;
     
-    VulkanUtils::createImage(vulkanDevice.device, vulkanDevice.physicalDevice, extent.width, extent.height, 1, false, vulkanDevice.getMsaaSamples(), colorFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colorImage, colorImageMemory);
+    VulkanUtils::createImage(vulkanDevice, extent.width, extent.height, 1, false, vulkanDevice.getMsaaSamples(), colorFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colorImage, colorImageMemory, MemoryCategory::Framebuffer);
     colorImageView = VulkanUtils::createImageView(vulkanDevice.device, colorImage, colorFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
     
     VulkanUtils::transitionImageLayout(vulkanDevice, colorImage, colorFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, 1);
@@ -44,7 +44,7 @@ void VulkanFramebuffer::createColorResources() {
 
 void VulkanFramebuffer::createDepthResources() {
     VkFormat depthFormat = swapchain.depthFormat;
-    VulkanUtils::createImage(vulkanDevice.device, vulkanDevice.physicalDevice, extent.width, extent.height, 1, false, vulkanDevice.getMsaaSamples(), depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage, depthImageMemory);
+    VulkanUtils::createImage(vulkanDevice, extent.width, extent.height, 1, false, vulkanDevice.getMsaaSamples(), depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage, depthImageMemory, MemoryCategory::Framebuffer);
     depthImageView = VulkanUtils::createImageView(vulkanDevice.device, depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
     
     VulkanUtils::transitionImageLayout(vulkanDevice, depthImage, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, 1);
@@ -52,7 +52,7 @@ void VulkanFramebuffer::createDepthResources() {
 
 void VulkanFramebuffer::createShadowDepthResources() {
     VkFormat depthFormat = VulkanRenderPasses::SHADOWS_DEPTH_FORMAT;
-    VulkanUtils::createImage(vulkanDevice.device, vulkanDevice.physicalDevice, SHADOWMAP_SIZE, SHADOWMAP_SIZE, 1, false, VK_SAMPLE_COUNT_1_BIT, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT  | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, shadowDepthImage, shadowDepthImageMemory);
+    VulkanUtils::createImage(vulkanDevice, SHADOWMAP_SIZE, SHADOWMAP_SIZE, 1, false, VK_SAMPLE_COUNT_1_BIT, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT  | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, shadowDepthImage, shadowDepthImageMemory, MemoryCategory::Framebuffer);
     shadowDepthImageView = VulkanUtils::createImageView(vulkanDevice.device, shadowDepthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
     
    // VulkanUtils::transitionImageLayout(vulkanDevice, shadowDepthImage, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, 1);
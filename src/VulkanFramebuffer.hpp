@@ -18,15 +18,15 @@ public:
     VkFramebuffer shadowFramebuffer;
     
     VkImage colorImage;
-    VkDeviceMemory colorImageMemory;
+    VulkanAllocation colorImageMemory;
     VkImageView colorImageView;
     
     VkImage depthImage;
-    VkDeviceMemory depthImageMemory;
+    VulkanAllocation depthImageMemory;
     VkImageView depthImageView;
     
     VkImage shadowDepthImage;
-    VkDeviceMemory shadowDepthImageMemory;
+    VulkanAllocation shadowDepthImageMemory;
     VkImageView shadowDepthImageView;
     VkSampler shadowSampler;
     
@@ -0,0 +1,288 @@
+#include "VulkanMemoryAllocator.hpp"
+
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+
+#include "VulkanUtils.hpp"
+
+struct VulkanMemoryBlock {
+    VkDeviceMemory memory;
+    VkDeviceSize size;
+    void* mapped;
+    uint32_t memoryType;
+    VulkanResourceKind kind;
+    VulkanAllocationStrategy strategy;
+
+    RangeAllocator ranges; // General strategy
+    VkDeviceSize linearOffset; // Linear strategy
+    uint32_t allocationCount;
+};
+
+VulkanMemoryAllocator::VulkanMemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice,
+                                             PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2)
+        : device(device), physicalDevice(physicalDevice), getMemoryProperties2(getMemoryProperties2) {
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+}
+
+VulkanMemoryAllocator::~VulkanMemoryAllocator() {
+    // Everything should have been freed by now, anything left is a leak
+    for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; i++) {
+        if (categoryUsage[i].allocationCount > 0) {
+            std::cout << "Leaked " << categoryUsage[i].allocationCount << " " << getCategoryName(static_cast<MemoryCategory>(i))
+                << " allocations (" << categoryUsage[i].liveBytes << " bytes)" << std::endl;
+        }
+    }
+
+    for (auto& block : blocks) {
+        vkFreeMemory(device, block->memory, nullptr);
+    }
+}
+
+VulkanAllocation VulkanMemoryAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, VulkanResourceKind kind,
+                                                 MemoryCategory category, VulkanAllocationStrategy strategy) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto memoryType = VulkanUtils::findMemoryType(physicalDevice, requirements.memoryTypeBits, properties);
+    auto blockSize = getBlockSize(memoryType);
+
+    VulkanAllocation allocation;
+    allocation.size = requirements.size;
+    allocation.memoryType = memoryType;
+    allocation.category = category;
+    addUsage(categoryUsage[static_cast<size_t>(category)], requirements.size);
+
+    // Large images and anything that wouldn't fit a block get their own memory
+    if ((kind == VulkanResourceKind::Image && requirements.size >= DEDICATED_IMAGE_SIZE) || requirements.size > blockSize) {
+        allocation.memory = allocateMemory(requirements.size, memoryType, &allocation.mapped);
+        dedicatedAllocationCount++;
+        dedicatedBytes += requirements.size;
+        return allocation;
+    }
+
+    for (auto& block : blocks) {
+        if (block->memoryType == memoryType && block->kind == kind && block->strategy == strategy
+                && allocateFromBlock(*block, requirements, allocation)) {
+            return allocation;
+        }
+    }
+
+    auto block = std::make_unique<VulkanMemoryBlock>();
+    block->memory = allocateMemory(blockSize, memoryType, &block->mapped);
+    block->size = blockSize;
+    block->memoryType = memoryType;
+    block->kind = kind;
+    block->strategy = strategy;
+    block->ranges = RangeAllocator(blockSize);
+    block->linearOffset = 0;
+    block->allocationCount = 0;
+
+    if (!allocateFromBlock(*block, requirements, allocation)) {
+        throw std::runtime_error("Allocation doesn't fit into a new memory block.");
+    }
+    blocks.push_back(std::move(block));
+    return allocation;
+}
+
+bool VulkanMemoryAllocator::allocateFromBlock(VulkanMemoryBlock& block, const VkMemoryRequirements& requirements, VulkanAllocation& allocation) {
+    VkDeviceSize offset;
+
+    if (block.strategy == VulkanAllocationStrategy::Linear) {
+        offset = (block.linearOffset + requirements.alignment - 1) / requirements.alignment * requirements.alignment;
+        if (offset + requirements.size > block.size) {
+            return false;
+        }
+        block.linearOffset = offset + requirements.size;
+    } else {
+        offset = block.ranges.allocate(requirements.size, requirements.alignment);
+        if (offset == RangeAllocator::INVALID_OFFSET) {
+            return false;
+        }
+    }
+
+    block.allocationCount++;
+    allocation.memory = block.memory;
+    allocation.offset = offset;
+    allocation.mapped = block.mapped != nullptr ? static_cast<char*>(block.mapped) + offset : nullptr;
+    allocation.block = &block;
+    return true;
+}
+
+void VulkanMemoryAllocator::free(VulkanAllocation& allocation) {
+    if (allocation.memory == VK_NULL_HANDLE) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    removeUsage(categoryUsage[static_cast<size_t>(allocation.category)], allocation.size);
+
+    if (allocation.block == nullptr) {
+        freeMemory(allocation.memory, allocation.size, allocation.memoryType);
+        dedicatedAllocationCount--;
+        dedicatedBytes -= allocation.size;
+        allocation = VulkanAllocation();
+        return;
+    }
+
+    auto& block = *allocation.block;
+    block.allocationCount--;
+    if (block.strategy == VulkanAllocationStrategy::Linear) {
+        if (block.allocationCount == 0) {
+            block.linearOffset = 0;
+        }
+    } else {
+        block.ranges.free(allocation.offset, allocation.size);
+    }
+
+    // Empty blocks are released, except for the last one of their kind so alternating allocations don't thrash
+    if (block.allocationCount == 0) {
+        auto sameKind = std::count_if(blocks.begin(), blocks.end(), [&block](const std::unique_ptr<VulkanMemoryBlock>& other) {
+            return other->memoryType == block.memoryType && other->kind == block.kind && other->strategy == block.strategy;
+        });
+
+        if (sameKind > 1) {
+            freeMemory(block.memory, block.size, block.memoryType);
+            blocks.erase(std::find_if(blocks.begin(), blocks.end(), [&block](const std::unique_ptr<VulkanMemoryBlock>& other) {
+                return other.get() == &block;
+            }));
+        }
+    }
+
+    allocation = VulkanAllocation();
+}
+
+VulkanMemoryStats VulkanMemoryAllocator::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    VulkanMemoryStats stats = {};
+    stats.blockCount = static_cast<uint32_t>(blocks.size());
+    stats.dedicatedAllocationCount = dedicatedAllocationCount;
+    stats.allocationCount = dedicatedAllocationCount;
+    stats.dedicatedBytes = dedicatedBytes;
+
+    for (const auto& block : blocks) {
+        stats.allocationCount += block->allocationCount;
+        stats.blockBytes += block->size;
+        stats.usedBlockBytes += block->strategy == VulkanAllocationStrategy::Linear ? block->linearOffset : block->ranges.getUsedSize();
+    }
+    return stats;
+}
+
+void VulkanMemoryAllocator::printStats() const {
+    auto stats = getStats();
+    const double megabyte = 1024.0 * 1024.0;
+
+    std::cout << "Device memory: " << stats.allocationCount << " allocations in " << stats.blockCount << " blocks ("
+        << stats.usedBlockBytes / megabyte << " / " << stats.blockBytes / megabyte << " MB used) and "
+        << stats.dedicatedAllocationCount << " dedicated (" << stats.dedicatedBytes / megabyte << " MB)" << std::endl;
+}
+
+VulkanMemoryUsage VulkanMemoryAllocator::getCategoryUsage(MemoryCategory category) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return categoryUsage[static_cast<size_t>(category)];
+}
+
+VulkanMemoryUsage VulkanMemoryAllocator::getHeapUsage(uint32_t heapIndex) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return heapUsage[heapIndex];
+}
+
+std::vector<VulkanHeapBudget> VulkanMemoryAllocator::getHeapBudgets() const {
+    std::vector<VulkanHeapBudget> budgets(memoryProperties.memoryHeapCount);
+
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+    budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    if (getMemoryProperties2 != nullptr) {
+        VkPhysicalDeviceMemoryProperties2 properties = {};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        properties.pNext = &budgetProperties;
+        getMemoryProperties2(physicalDevice, &properties);
+    }
+
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+        auto& heap = memoryProperties.memoryHeaps[i];
+        budgets[i].size = heap.size;
+        budgets[i].deviceLocal = (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+
+        if (getMemoryProperties2 != nullptr) {
+            budgets[i].budget = budgetProperties.heapBudget[i];
+            budgets[i].usage = budgetProperties.heapUsage[i];
+        } else {
+            budgets[i].budget = heap.size;
+            budgets[i].usage = getHeapUsage(i).liveBytes;
+        }
+    }
+    return budgets;
+}
+
+void VulkanMemoryAllocator::printReport() const {
+    const double megabyte = 1024.0 * 1024.0;
+
+    std::cout << "Device memory by category:" << std::endl;
+    for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; i++) {
+        auto usage = getCategoryUsage(static_cast<MemoryCategory>(i));
+        std::cout << "  " << getCategoryName(static_cast<MemoryCategory>(i)) << ": " << usage.allocationCount << " allocations, "
+            << usage.liveBytes / megabyte << " MB (peak " << usage.peakBytes / megabyte << " MB)" << std::endl;
+    }
+
+    std::cout << "Device memory by heap" << (getMemoryProperties2 != nullptr ? " (VK_EXT_memory_budget):" : ":") << std::endl;
+    auto budgets = getHeapBudgets();
+    for (uint32_t i = 0; i < budgets.size(); i++) {
+        auto usage = getHeapUsage(i);
+        std::cout << "  Heap " << i << (budgets[i].deviceLocal ? " (device local): " : ": ") << usage.liveBytes / megabyte
+            << " MB allocated (peak " << usage.peakBytes / megabyte << " MB), process usage " << budgets[i].usage / megabyte
+            << " of " << budgets[i].budget / megabyte << " MB budget, heap size " << budgets[i].size / megabyte << " MB" << std::endl;
+    }
+}
+
+const char* VulkanMemoryAllocator::getCategoryName(MemoryCategory category) {
+    switch (category) {
+        case MemoryCategory::Mesh: return "Mesh";
+        case MemoryCategory::Texture: return "Texture";
+        case MemoryCategory::Uniform: return "Uniform";
+        case MemoryCategory::Framebuffer: return "Framebuffer";
+        case MemoryCategory::Staging: return "Staging";
+    }
+    return "Unknown";
+}
+
+VkDeviceSize VulkanMemoryAllocator::getBlockSize(uint32_t memoryType) const {
+    // Small heaps (e.g. the host-visible device-local window) get smaller blocks
+    auto heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryType].heapIndex].size;
+    return std::min(DEFAULT_BLOCK_SIZE, heapSize / 8);
+}
+
+VkDeviceMemory VulkanMemoryAllocator::allocateMemory(VkDeviceSize size, uint32_t memoryType, void** mapped) {
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryType;
+
+    VkDeviceMemory memory;
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate device memory!");
+    }
+    addUsage(heapUsage[memoryProperties.memoryTypes[memoryType].heapIndex], size);
+
+    *mapped = nullptr;
+    if (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, mapped);
+    }
+    return memory;
+}
+
+void VulkanMemoryAllocator::freeMemory(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryType) {
+    vkFreeMemory(device, memory, nullptr);
+    removeUsage(heapUsage[memoryProperties.memoryTypes[memoryType].heapIndex], size);
+}
+
+void VulkanMemoryAllocator::addUsage(VulkanMemoryUsage& usage, VkDeviceSize size) {
+    usage.allocationCount++;
+    usage.liveBytes += size;
+    usage.peakBytes = std::max(usage.peakBytes, usage.liveBytes);
+}
+
+void VulkanMemoryAllocator::removeUsage(VulkanMemoryUsage& usage, VkDeviceSize size) {
+    usage.allocationCount--;
+    usage.liveBytes -= size;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <memory>
+#include <mutex>
+
+#include "RangeAllocator.hpp"
+
+enum class VulkanResourceKind {
+    Buffer,
+    Image // Optimally tiled, kept in separate blocks from buffers so bufferImageGranularity never applies
+};
+
+enum class VulkanAllocationStrategy {
+    General, // Free list, for resources with arbitrary lifetimes
+    Linear // Bump allocation, the block resets once all its allocations are freed. For short-lived staging data.
+};
+
+/** What an allocation is used for, live and peak bytes are tracked per category */
+enum class MemoryCategory {
+    Mesh,
+    Texture,
+    Uniform,
+    Framebuffer,
+    Staging
+};
+
+const size_t MEMORY_CATEGORY_COUNT = 5;
+
+struct VulkanMemoryBlock;
+
+struct VulkanAllocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    void* mapped = nullptr; // Persistently mapped address of offset, for host-visible memory
+    VulkanMemoryBlock* block = nullptr; // Null for dedicated allocations
+    uint32_t memoryType = 0;
+    MemoryCategory category = MemoryCategory::Mesh;
+};
+
+struct VulkanMemoryStats {
+    uint32_t blockCount;
+    uint32_t dedicatedAllocationCount;
+    uint32_t allocationCount; // Including dedicated ones
+    VkDeviceSize blockBytes; // Device memory held by blocks
+    VkDeviceSize usedBlockBytes; // Part of it handed out to allocations
+    VkDeviceSize dedicatedBytes;
+};
+
+struct VulkanMemoryUsage {
+    uint32_t allocationCount = 0;
+    VkDeviceSize liveBytes = 0;
+    VkDeviceSize peakBytes = 0;
+};
+
+struct VulkanHeapBudget {
+    VkDeviceSize size;
+    VkDeviceSize budget; // How much the process can use, from VK_EXT_memory_budget or the heap size without it
+    VkDeviceSize usage; // Process-wide usage from VK_EXT_memory_budget, our own allocations without it
+    bool deviceLocal;
+};
+
+/**
+ * Sub-allocates resources from large device memory blocks per memory type, so the renderer stays far below
+ * maxMemoryAllocationCount. Host-visible blocks are mapped once when they are created.
+ */
+class VulkanMemoryAllocator {
+
+public:
+    /** getMemoryProperties2 is only passed when VK_EXT_memory_budget is enabled */
+    VulkanMemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice,
+                          PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2 = nullptr);
+    virtual ~VulkanMemoryAllocator();
+
+    VulkanAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, VulkanResourceKind kind,
+                              MemoryCategory category, VulkanAllocationStrategy strategy = VulkanAllocationStrategy::General);
+    void free(VulkanAllocation& allocation);
+
+    VulkanMemoryStats getStats() const;
+    void printStats() const;
+
+    /** Bytes requested by resources of the category */
+    VulkanMemoryUsage getCategoryUsage(MemoryCategory category) const;
+    /** Device memory allocated from the heap, including unused space in blocks */
+    VulkanMemoryUsage getHeapUsage(uint32_t heapIndex) const;
+    std::vector<VulkanHeapBudget> getHeapBudgets() const;
+
+    /** Usage per category and heap, compared to the heaps' budgets */
+    void printReport() const;
+
+    static const char* getCategoryName(MemoryCategory category);
+
+private:
+    VkDevice device;
+    VkPhysicalDevice physicalDevice;
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2;
+    std::vector<std::unique_ptr<VulkanMemoryBlock>> blocks;
+    uint32_t dedicatedAllocationCount = 0;
+    VkDeviceSize dedicatedBytes = 0;
+    VulkanMemoryUsage categoryUsage[MEMORY_CATEGORY_COUNT];
+    VulkanMemoryUsage heapUsage[VK_MAX_MEMORY_HEAPS];
+    mutable std::mutex mutex;
+
+    static const VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull << 20;
+    static const VkDeviceSize DEDICATED_IMAGE_SIZE = 16ull << 20; // Images from this size on get their own memory
+
+    VkDeviceSize getBlockSize(uint32_t memoryType) const;
+    VkDeviceMemory allocateMemory(VkDeviceSize size, uint32_t memoryType, void** mapped);
+    void freeMemory(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryType);
+
+    static void addUsage(VulkanMemoryUsage& usage, VkDeviceSize size);
+    static void removeUsage(VulkanMemoryUsage& usage, VkDeviceSize size);
+    bool allocateFromBlock(VulkanMemoryBlock& block, const VkMemoryRequirements& requirements, VulkanAllocation& allocation);
+
+};
@@ -11,21 +11,32 @@
 
 #include "VulkanUtils.hpp"
 #include "VulkanBuffer.hpp"
+#include "UploadQueue.hpp"
+#include "StagingRing.hpp"
+#include "BindlessResources.hpp"
 
 VulkanTexture::VulkanTexture(std::string path, VulkanDevice& device, bool srgb) : srgb(srgb), cubeMap(false), device(device) {
     createTextureImage(path);
     createTextureImageView();
     createTextureSampler();
+    
+    if (device.bindlessResources) {
+        bindlessIndex = device.bindlessResources->registerTexture(getDescriptorImageInfo());
+    }
 }
 
 VulkanTexture::VulkanTexture(VulkanDevice& device, bool srgb) : srgb(srgb), device(device) {}
 
 VulkanTexture::~VulkanTexture() {
+    if (bindlessIndex != BindlessResources::INVALID_INDEX && device.bindlessResources) {
+        device.bindlessResources->unregisterTexture(bindlessIndex);
+    }
+    
     vkDestroySampler(device.device, textureSampler, nullptr);
     vkDestroyImageView(device.device, textureImageView, nullptr);
     
     vkDestroyImage(device.device, textureImage, nullptr);
-    vkFreeMemory(device.device, textureImageMemory, nullptr);
+    device.memoryAllocator->free(textureImageMemory);
 }
 
 VkDescriptorImageInfo VulkanTexture::getDescriptorImageInfo() {
@@ -57,26 +68,20 @@ void VulkanTexture::createTextureImage(std::string path) {
         throw std::runtime_error("failed to load texture image!");
     }
     
-    VulkanBuffer stagingBuffer;
-    device.createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer);
+    auto staging = device.stagingRing->allocate(imageSize);
     
-    void* data;
-    vkMapMemory(device.device, stagingBuffer.memory, 0, imageSize, 0, &data);
-    memcpy(data, pixels, static_cast<size_t>(imageSize));
-    vkUnmapMemory(device.device, stagingBuffer.memory);
+    memcpy(staging.mapped, pixels, static_cast<size_t>(imageSize));
     
     stbi_image_free(pixels);
     
     auto format = srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
     
-    VulkanUtils::createImage(device.device, device.physicalDevice, texWidth, texHeight, mipLevels, false, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory);
+    VulkanUtils::createImage(device, texWidth, texHeight, mipLevels, false, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, MemoryCategory::Texture);
     
     VulkanUtils::transitionImageLayout(device, textureImage, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
-    VulkanUtils::copyBufferToImage(device, stagingBuffer.buffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
+    VulkanUtils::copyBufferToImage(device, staging.buffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 0, staging.offset);
     //transitioned to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL while generating mipmaps
     
-    device.freeBuffer(stagingBuffer);
-    
     generateMipmaps(textureImage, format, texWidth, texHeight, mipLevels);
 }
 
@@ -93,26 +98,20 @@ void VulkanTexture::createCubemapTextureImage(std::array<std::string, 6> paths)
             throw std::runtime_error("failed to load texture image!");
         }
         
-        VulkanBuffer stagingBuffer;
-        device.createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer);
+        auto staging = device.stagingRing->allocate(imageSize);
         
-        void* data;
-        vkMapMemory(device.device, stagingBuffer.memory, 0, imageSize, 0, &data);
-        memcpy(data, pixels, static_cast<size_t>(imageSize));
-        vkUnmapMemory(device.device, stagingBuffer.memory);
+        memcpy(staging.mapped, pixels, static_cast<size_t>(imageSize));
         
         stbi_image_free(pixels);
         
         if (textureImage == nullptr) {
             // TODO: create the image with the dimensions of the first texture
-            VulkanUtils::createImage(device.device, device.physicalDevice, texWidth, texHeight, mipLevels, true, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory);
+            VulkanUtils::createImage(device, texWidth, texHeight, mipLevels, true, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, MemoryCategory::Texture);
             
             VulkanUtils::transitionImageLayout(device, textureImage, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, 0, 6);
         }
         
-        VulkanUtils::copyBufferToImage(device, stagingBuffer.buffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), i);
-        
-        device.freeBuffer(stagingBuffer);
+        VulkanUtils::copyBufferToImage(device, staging.buffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), i, staging.offset);
     }
     
     VulkanUtils::transitionImageLayout(device, textureImage, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1, 0, 6);
@@ -156,7 +155,7 @@ void VulkanTexture::generateMipmaps(VkImage image, VkFormat imageFormat, int32_t
         throw std::runtime_error("texture image format does not support linear blitting!");
     }
     
-    VkCommandBuffer commandBuffer = VulkanUtils::beginSingleTimeCommands(device);
+    VkCommandBuffer commandBuffer = device.uploadQueue->getCommandBuffer();
     
     VkImageMemoryBarrier barrier = {};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -230,6 +229,4 @@ void VulkanTexture::generateMipmaps(VkImage image, VkFormat imageFormat, int32_t
                          0, nullptr,
                          0, nullptr,
                          1, &barrier);
-    
-    VulkanUtils::endSingleTimeCommands(commandBuffer, device);
 }
@@ -15,6 +15,8 @@ public:
     ~VulkanTexture();
     
     VkDescriptorImageInfo getDescriptorImageInfo();
+    /** Slot in the bindless texture array, invalid for cubemaps and without bindless support */
+    uint32_t getBindlessIndex() const { return bindlessIndex; }
     
     static std::shared_ptr<VulkanTexture> loadCubemap(std::array<std::string, 6> paths, VulkanDevice& device, bool srgb);
     
@@ -22,8 +24,9 @@ private:
     bool srgb;
     bool cubeMap;
     uint32_t mipLevels = 1;
+    uint32_t bindlessIndex = ~0u;
     VkImage textureImage = nullptr;
-    VkDeviceMemory textureImageMemory;
+    VulkanAllocation textureImageMemory;
     VkImageView textureImageView;
     VkSampler textureSampler;
     
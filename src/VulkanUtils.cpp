@@ -2,6 +2,8 @@
 
 #include <vector>
 
+#include "UploadQueue.hpp"
+
 VkImageView VulkanUtils::createImageView(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels, bool cubeMap) {
     VkImageViewCreateInfo viewInfo = {};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -22,9 +24,9 @@ VkImageView VulkanUtils::createImageView(VkDevice device, VkImage image, VkForma
     return imageView;
 }
 
-void VulkanUtils::createImage(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t width, uint32_t height,
+void VulkanUtils::createImage(VulkanDevice& device, uint32_t width, uint32_t height,
                               uint32_t mipLevels, bool cubeMap, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling,
-                              VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory) {
+                              VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VulkanAllocation& imageMemory, MemoryCategory category) {
     VkImageCreateInfo imageInfo = {};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imageInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -43,23 +45,17 @@ void VulkanUtils::createImage(VkDevice device, VkPhysicalDevice physicalDevice,
         imageInfo.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
     }
     
-    if (vkCreateImage(device, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+    if (vkCreateImage(device.device, &imageInfo, nullptr, &image) != VK_SUCCESS) {
         throw std::runtime_error("failed to create image!");
     }
     
     VkMemoryRequirements memRequirements;
-    vkGetImageMemoryRequirements(device, image, &memRequirements);
-    
-    VkMemoryAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(physicalDevice, memRequirements.memoryTypeBits, properties);
-    
-    if (vkAllocateMemory(device, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate image memory!");
-    }
+    vkGetImageMemoryRequirements(device.device, image, &memRequirements);
     
-    vkBindImageMemory(device, image, imageMemory, 0);
+    // Linearly tiled images would have to share blocks with buffers and respect bufferImageGranularity
+    auto kind = tiling == VK_IMAGE_TILING_OPTIMAL ? VulkanResourceKind::Image : VulkanResourceKind::Buffer;
+    imageMemory = device.memoryAllocator->allocate(memRequirements, properties, kind, category);
+    vkBindImageMemory(device.device, image, imageMemory.memory, imageMemory.offset);
 }
 
 uint32_t VulkanUtils::findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties) {
@@ -100,7 +96,7 @@ VkFormat VulkanUtils::findSupportedFormat(VkPhysicalDevice physicalDevice, const
 }
 
 void VulkanUtils::transitionImageLayout(VulkanDevice& device, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels, uint32_t baseArrayLayer, uint32_t layerCount) {
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands(device);
+    VkCommandBuffer commandBuffer = device.uploadQueue->getCommandBuffer();
     
     VkImageMemoryBarrier barrier = {};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -163,8 +159,6 @@ void VulkanUtils::transitionImageLayout(VulkanDevice& device, VkImage image, VkF
                          0, nullptr,
                          1, &barrier
                          );
-    
-    endSingleTimeCommands(commandBuffer, device);
 }
 
 bool VulkanUtils::hasStencilComponent(VkFormat format) {
@@ -204,21 +198,21 @@ void VulkanUtils::endSingleTimeCommands(VkCommandBuffer commandBuffer, VulkanDev
     vkFreeCommandBuffers(device.device, device.commandPool, 1, &commandBuffer);
 }
 
-void VulkanUtils::copyBuffer(VulkanDevice& device, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands(device);
+void VulkanUtils::copyBuffer(VulkanDevice& device, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset) {
+    VkCommandBuffer commandBuffer = device.uploadQueue->getBufferCopyCommandBuffer(srcBuffer, srcOffset, dstBuffer, dstOffset, size);
     
     VkBufferCopy copyRegion = {};
+    copyRegion.srcOffset = srcOffset;
+    copyRegion.dstOffset = dstOffset;
     copyRegion.size = size;
     vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-    
-    endSingleTimeCommands(commandBuffer, device);
 }
 
-void VulkanUtils::copyBufferToImage(VulkanDevice& device, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t arrayLayer) {
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands(device);
+void VulkanUtils::copyBufferToImage(VulkanDevice& device, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t arrayLayer, VkDeviceSize bufferOffset) {
+    VkCommandBuffer commandBuffer = device.uploadQueue->getCommandBuffer();
     
     VkBufferImageCopy region = {};
-    region.bufferOffset = 0;
+    region.bufferOffset = bufferOffset;
     region.bufferRowLength = 0;
     region.bufferImageHeight = 0;
     region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -233,6 +227,4 @@ void VulkanUtils::copyBufferToImage(VulkanDevice& device, VkBuffer buffer, VkIma
     };
     
     vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-    
-    endSingleTimeCommands(commandBuffer, device);
 }
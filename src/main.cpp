@@ -11,6 +11,7 @@
 #include "Window.hpp"
 #include "Splines.hpp"
 #include "KdTree.hpp"
+#include "BindlessResources.hpp"
 
 const std::string MECH_PATH = "models/model.dae";
 const std::string CUBE_PATH = "models/cube.obj";
@@ -76,6 +77,9 @@ void keyPressedCallback(GLFWwindow* nativeWindow, int key, int scancode, int act
     else if (key == GLFW_KEY_L) {
         rayLocked = !rayLocked;
     }
+    else if (key == GLFW_KEY_G) {
+        renderer->getDevice().memoryAllocator->printReport();
+    }
 }
 
 int modulo(int a, int b) {
@@ -151,17 +155,22 @@ int main() {
         "textures/back.jpg"
     }, renderer->getDevice(), true);
     
-    auto characterUniforms = std::make_shared<Uniforms<LocalTransform>>(renderer->getDevice(), 3, true);
+    // With descriptor indexing, textured models read their textures from the bindless array instead of binding them
+    auto& bindlessResources = renderer->getDevice().bindlessResources;
+    size_t materialTextureNum = bindlessResources ? 0 : 3;
+    
+    auto characterUniforms = std::make_shared<Uniforms<LocalTransform>>(renderer->getDevice(), materialTextureNum, true);
     auto skyboxUniforms = std::make_shared<Uniforms<LocalTransform>>(renderer->getDevice(), 1, false);
-    auto groundUniforms = std::make_shared<Uniforms<LocalTransform>>(renderer->getDevice(), 3, true);
+    auto groundUniforms = std::make_shared<Uniforms<LocalTransform>>(renderer->getDevice(), materialTextureNum, true);
     auto kdTreeUniforms = std::make_shared<Uniforms<LocalTransform>>(renderer->getDevice(), 0, true);
     auto hitTriangleUniforms = std::make_shared<Uniforms<LocalTransform>>(renderer->getDevice(), 0, true);
     auto hitIndicatorUniforms = std::make_shared<Uniforms<LocalTransform>>(renderer->getDevice(), 0, true);
     
     auto staticPipeline = PipelineSettingsBuilder()
-        .vertexShader("shaders/static.vert.spv")
+        .vertexShader("shaders/static_packed.vert.spv")
         .shadowVertexShader("shaders/shadowpass.vert.spv")
-        .fragmentShader("shaders/shader.frag.spv")
+        .fragmentShader(bindlessResources ? "shaders/shader_bindless.frag.spv" : "shaders/shader.frag.spv")
+        .vertexFormat(VertexFormat::Packed)
         .build();
 
     auto linesPipeline = PipelineSettingsBuilder()
@@ -177,8 +186,9 @@ int main() {
         .build();
 
     auto hitIndicatorPipeline = PipelineSettingsBuilder()
-        .vertexShader("shaders/static.vert.spv")
+        .vertexShader("shaders/static_packed.vert.spv")
         .fragmentShader("shaders/greensolid.frag.spv")
+        .vertexFormat(VertexFormat::Packed)
         .build();
     
     auto skyboxPipeline = PipelineSettingsBuilder()
@@ -187,6 +197,7 @@ int main() {
         .depthWrite(false)
         .depthCompareOp(VK_COMPARE_OP_LESS_OR_EQUAL)
         .cullMode(VK_CULL_MODE_FRONT_BIT)
+        .vertexFormat(VertexFormat::Packed) // Only reads positions, so the regular shader works
         .build();
     
     auto character = ModelLoader::fromFile(MECH_PATH, renderer->getDevice(), staticPipeline, std::move(characterUniforms));
@@ -194,23 +205,32 @@ int main() {
     auto ground = ModelLoader::fromFile(TERRAIN_PATH, renderer->getDevice(), staticPipeline, std::move(groundUniforms));
     auto hitIndicator = ModelLoader::fromFile(SPHERE_PATH, renderer->getDevice(), hitIndicatorPipeline, std::move(hitIndicatorUniforms));
     
-    character->getUniforms().addTexture(2, std::move(colorTexture));
-    character->getUniforms().addTexture(3, std::move(maskTexture));
-    character->getUniforms().addTexture(4, std::move(normalMapTexture));
+    if (bindlessResources) {
+        character->getUniforms().ubo.materialIndex = bindlessResources->addMaterial(std::move(colorTexture), std::move(maskTexture), std::move(normalMapTexture));
+    } else {
+        character->getUniforms().addTexture(1, std::move(colorTexture));
+        character->getUniforms().addTexture(2, std::move(maskTexture));
+        character->getUniforms().addTexture(3, std::move(normalMapTexture));
+    }
     
     colorTexture = std::make_shared<VulkanTexture>(TEXTURE_PATH, renderer->getDevice(), true);
     maskTexture = std::make_shared<VulkanTexture>(MASK_TEXTURE_PATH, renderer->getDevice(), false);
     normalMapTexture = std::make_shared<VulkanTexture>(NORMAL_MAP_PATH, renderer->getDevice(), false);
     
-    ground->getUniforms().addTexture(2, std::move(groundColorTexture));
-    ground->getUniforms().addTexture(3, std::move(groundMaskTexture));
-    ground->getUniforms().addTexture(4, std::move(groundNormalMapTexture));
+    if (bindlessResources) {
+        ground->getUniforms().ubo.materialIndex = bindlessResources->addMaterial(std::move(groundColorTexture), std::move(groundMaskTexture), std::move(groundNormalMapTexture));
+    } else {
+        ground->getUniforms().addTexture(1, std::move(groundColorTexture));
+        ground->getUniforms().addTexture(2, std::move(groundMaskTexture));
+        ground->getUniforms().addTexture(3, std::move(groundNormalMapTexture));
+    }
 
-    skybox->getUniforms().addTexture(2, std::move(skyboxTexture));
+    skybox->getUniforms().addTexture(1, std::move(skyboxTexture));
 
     character->position = glm::vec3(0.0f, 0.5f, 0.0f);
 
     skybox->scale = glm::vec3(10.0f, 10.0f, 10.0f);
+    skybox->frustumCulling = false;
 
     ground->position = glm::vec3(0.0f, -0.05f, 0.0f);
     ground->scale = glm::vec3(15.0f, 15.0f, 15.0f);
@@ -307,6 +327,22 @@ int main() {
                 std::cout << "NormalIntensity: " << normalIntensity << std::endl;
             }
 
+            if (window->getKey(GLFW_KEY_B)) {
+                auto& stats = renderer->getAnimationStats();
+                std::cout << "Animated instances: " << stats.updatedInstances << " updated, " << stats.skippedInstances << " skipped, "
+                    << "joints: " << stats.evaluatedJoints << " evaluated, " << stats.skippedJoints << " skipped" << std::endl;
+
+                auto& meshletStats = renderer->getMeshletStats();
+                std::cout << "Meshlets: " << meshletStats.visibleMeshlets << " visible, " << meshletStats.frustumCulledMeshlets << " outside the frustum, "
+                    << meshletStats.backfaceCulledMeshlets << " back-facing, " << meshletStats.submittedTriangles << " triangles submitted" << std::endl;
+
+                auto& cullingStats = renderer->getCullingStats();
+                std::cout << "Meshes: " << cullingStats.visibleMeshes << " of " << cullingStats.testedMeshes << " tested visible, "
+                    << cullingStats.untestedMeshes << " not tested" << std::endl;
+
+                renderer->getDevice().memoryAllocator->printStats();
+            }
+
             normalIntensity = glm::clamp(normalIntensity, 0.01f, 15.0f);
             renderer->getGlobals().normalIntensity = normalIntensity;
 
@@ -348,9 +384,6 @@ int main() {
                 cam.rotation = waypoint.rotation;
             }
 
-            auto& characterUniforms = character->getUniforms();
-            auto& groundUniforms = ground->getUniforms();
-            
             // -- Shadow map uniforms --
             // Keep depth range as small as possible for better shadow map precision
             float zNear = 0.1f;
@@ -358,8 +391,7 @@ int main() {
             glm::mat4 depthProjectionMatrix = glm::perspective(glm::radians(90.0f), 1.0f, zNear, zFar);
             glm::mat4 depthViewMatrix = glm::lookAt(lightPos, lightPos - lightDir, glm::vec3(0, 1, 0));
             
-            characterUniforms.ubo.lightSpace = depthProjectionMatrix * depthViewMatrix;
-            groundUniforms.ubo.lightSpace = depthProjectionMatrix * depthViewMatrix;
+            renderer->getGlobals().lightSpace = depthProjectionMatrix * depthViewMatrix;
 
             // KdTree raycast
             glm::vec3 direction = glm::vec3(0.0f, 0.0f, 1.0f) * cam.rotation;
@@ -396,6 +428,11 @@ int main() {
         return EXIT_FAILURE;
     }
     
+    // Meshes free their geometry in the device's arenas, so every model has to go before the renderer
+    kdTreeTriModel.reset();
+    kdTreeModel.reset();
+    kdTree.reset();
+    hitIndicator.reset();
     ground.reset();
     skybox.reset();
     character.reset();